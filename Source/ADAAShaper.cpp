@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    ADAAShaper.cpp
+
+  ==============================================================================
+*/
+
+#include "ADAAShaper.h"
+
+//==============================================================================
+namespace
+{
+    // below this input step the divided differences lose too many digits, so the kernels
+    // fall back to evaluating at the midpoint. It's relative to the input's size because
+    // the antiderivatives grow like x^2, and so does their rounding error
+    inline bool isIllConditioned (double difference, double x) noexcept
+    {
+        return std::abs (difference) < 1.0e-5 * (1.0 + std::abs (x));
+    }
+
+    template <typename Algorithm, typename SampleType>
+    void processFirstOrder (SampleType* data, int numSamples, typename ADAAShaper<SampleType>::ChannelState& state) noexcept
+    {
+        auto x1 = state.x1;
+        auto antiderivative1 = state.antiderivative1;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x0 = (double) data[i];
+            auto a0 = Algorithm::antiderivative1 (x0);
+            auto difference = x0 - x1;
+
+            data[i] = (SampleType) (isIllConditioned (difference, x0) ? Algorithm::process (0.5 * (x0 + x1))
+                                                                       : (a0 - antiderivative1) / difference);
+
+            x1 = x0;
+            antiderivative1 = a0;
+        }
+
+        state.x1 = x1;
+        state.antiderivative1 = antiderivative1;
+    }
+
+    template <typename Algorithm, typename SampleType>
+    void processSecondOrder (SampleType* data, int numSamples, typename ADAAShaper<SampleType>::ChannelState& state) noexcept
+    {
+        auto x1 = state.x1, x2 = state.x2;
+        auto antiderivative2 = state.antiderivative2;
+        auto d2 = state.d1;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x0 = (double) data[i];
+            auto a0 = Algorithm::antiderivative2 (x0);
+
+            // divided difference of the second antiderivative over [x1, x0]
+            auto step = x0 - x1;
+            auto d1 = isIllConditioned (step, x0) ? Algorithm::antiderivative1 (0.5 * (x0 + x1))
+                                                  : (a0 - antiderivative2) / step;
+
+            auto span = x0 - x2;
+            double y;
+
+            if (! isIllConditioned (span, x0))
+            {
+                y = 2.0 / span * (d1 - d2);
+            }
+            else
+            {
+                // x0 and x2 coincide, so expand around their midpoint instead
+                auto xBar = 0.5 * (x0 + x2);
+                auto delta = xBar - x1;
+
+                y = isIllConditioned (delta, xBar) ? Algorithm::process (0.5 * (xBar + x1))
+                                                   : 2.0 / delta * (Algorithm::antiderivative1 (xBar)
+                                                                     + (antiderivative2 - Algorithm::antiderivative2 (xBar)) / delta);
+            }
+
+            data[i] = (SampleType) y;
+
+            x2 = x1;
+            x1 = x0;
+            antiderivative2 = a0;
+            d2 = d1;
+        }
+
+        state.x1 = x1;
+        state.x2 = x2;
+        state.antiderivative2 = antiderivative2;
+        state.d1 = d2;
+    }
+
+    // fills the history as if the input had been sitting at x, so a restart doesn't click
+    template <typename Algorithm, typename SampleType>
+    void primeState (typename ADAAShaper<SampleType>::ChannelState& state, double x) noexcept
+    {
+        state.x1 = state.x2 = x;
+        state.antiderivative1 = Algorithm::antiderivative1 (x);
+        state.antiderivative2 = Algorithm::antiderivative2 (x);
+        state.d1 = Algorithm::antiderivative1 (x);
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+ADAAShaper<SampleType>::ADAAShaper()
+{
+    ShaperAlgorithms::forEach ([this] (auto algorithm, int type)
+    {
+        using Algorithm = decltype (algorithm);
+
+        firstOrderKernels[type] = processFirstOrder<Algorithm, SampleType>;
+        secondOrderKernels[type] = processSecondOrder<Algorithm, SampleType>;
+        primeFunctions[type] = primeState<Algorithm, SampleType>;
+    });
+}
+
+template <typename SampleType>
+void ADAAShaper<SampleType>::prepare (int numChannels)
+{
+    channelStates.resize ((size_t) numChannels);
+    reset();
+}
+
+template <typename SampleType>
+void ADAAShaper<SampleType>::reset() noexcept
+{
+    std::fill (channelStates.begin(), channelStates.end(), ChannelState());
+    lastShaperType = -1;
+    lastOrder = off;
+}
+
+template <typename SampleType>
+void ADAAShaper<SampleType>::process (juce::dsp::AudioBlock<SampleType>& block, int shaperType, int order) noexcept
+{
+    jassert (order == firstOrder || order == secondOrder);
+    jassert (block.getNumChannels() <= channelStates.size());
+
+    auto restart = shaperType != lastShaperType || order != lastOrder;
+    lastShaperType = shaperType;
+    lastOrder = order;
+
+    auto kernel = order == secondOrder ? secondOrderKernels[shaperType] : firstOrderKernels[shaperType];
+    auto numSamples = (int) block.getNumSamples();
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* channelData = block.getChannelPointer (channel);
+        auto& state = channelStates[channel];
+
+        if (restart && numSamples > 0)
+            primeFunctions[shaperType] (state, (double) channelData[0]);
+
+        kernel (channelData, numSamples, state);
+    }
+}
+
+//==============================================================================
+template class ADAAShaper<float>;
+template class ADAAShaper<double>;
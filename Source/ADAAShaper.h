@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    ADAAShaper.h
+
+    Antiderivative antialiasing for the shaper curves. Instead of evaluating
+    the curve at each sample, first order ADAA outputs the curve's average
+    between consecutive input samples, and second order does the same one
+    integration further up. Most of the aliasing of the plain shaper goes
+    away without any oversampling, at the cost of a half (first order) or
+    one (second order) sample delay.
+
+    Parker, Zavalishin & Le Bivic, "Reducing the aliasing of nonlinear
+    waveshaping using continuous-time convolution", DAFx 2016, and
+    Bilbao, Esqueda, Parker & Valimaki, "Antiderivative antialiasing for
+    memoryless nonlinearities", IEEE SPL 2017.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ShaperAlgorithms.h"
+
+template <typename SampleType>
+class ADAAShaper
+{
+public:
+    /** The choices of the antialiasing parameter. */
+    enum Order
+    {
+        off = 0,
+        firstOrder,
+        secondOrder
+    };
+
+    /** The group delay ADAA adds, in samples at the rate it runs at. */
+    static double getDelaySamples (int order) noexcept     { return 0.5 * order; }
+
+    ADAAShaper();
+
+    /** Allocates the per-channel history. */
+    void prepare (int numChannels);
+    void reset() noexcept;
+
+    /** Shapes every channel of the block in place with the given algorithm and order.
+        Switching algorithm or order restarts the history from the block's first sample,
+        so a change never reads a history computed for a different curve.
+    */
+    void process (juce::dsp::AudioBlock<SampleType>& block, int shaperType, int order) noexcept;
+
+    /** Each channel's history, kept in double because ADAA divides differences of the
+        antiderivatives by the input step, which float can't resolve.
+    */
+    struct ChannelState
+    {
+        double x1 = 0, x2 = 0;                  // the previous two inputs
+        double antiderivative1 = 0;             // first antiderivative at x1, for first order
+        double antiderivative2 = 0, d1 = 0;     // second antiderivative at x1 and the last divided difference, for second order
+    };
+
+    using KernelFunction = void (*) (SampleType* data, int numSamples, ChannelState& state);
+
+private:
+    std::vector<ChannelState> channelStates;
+    int lastShaperType = -1, lastOrder = off;
+
+    // one generated kernel per algorithm and order, picked once per block
+    KernelFunction firstOrderKernels[ShaperAlgorithms::numTypes];
+    KernelFunction secondOrderKernels[ShaperAlgorithms::numTypes];
+
+    using PrimeFunction = void (*) (ChannelState& state, double x);
+    PrimeFunction primeFunctions[ShaperAlgorithms::numTypes];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ADAAShaper)
+};
@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+    BandSplitter.cpp
+
+  ==============================================================================
+*/
+
+#include "BandSplitter.h"
+
+//==============================================================================
+namespace
+{
+    enum class CrossoverResponse { lowPass, highPass, allPass };
+
+    // one second order Butterworth section of a 4th order Linkwitz-Riley crossover, bilinear
+    // transformed. Two lowpass or two highpass sections make the LR4 filters, and LR4 lowpass
+    // plus highpass is exactly one second order allpass, which the second section leaves alone
+    std::array<double, 5> makeCrossoverSection (CrossoverResponse response, int section, double frequency, double sampleRate) noexcept
+    {
+        auto k = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto norm = 1.0 / (1.0 + juce::MathConstants<double>::sqrt2 * k + k * k);
+        auto a1 = 2.0 * (k * k - 1.0) * norm;
+        auto a2 = (1.0 - juce::MathConstants<double>::sqrt2 * k + k * k) * norm;
+
+        if (response == CrossoverResponse::lowPass)
+            return {{ k * k * norm, 2.0 * k * k * norm, k * k * norm, a1, a2 }};
+
+        if (response == CrossoverResponse::highPass)
+            return {{ norm, -2.0 * norm, norm, a1, a2 }};
+
+        if (section == 0)
+            return {{ a2, a1, 1.0, a1, a2 }};
+
+        return {{ 1.0, 0.0, 0.0, 0.0, 0.0 }};
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void BandSplitter<SampleType>::prepare (int numChannelsToUse, int maximumSamples)
+{
+    numChannels = numChannelsToUse;
+
+    channelStates.resize ((size_t) (numChannels * numGroups));
+    bandBuffer.setSize (numChannels * maxBands, maximumSamples);
+    interleaved = juce::dsp::AudioBlock<Register> (interleavedData, (size_t) (numChannels * numGroups), (size_t) maximumSamples);
+    scratch = juce::dsp::AudioBlock<Register> (scratchData, 2, (size_t) maximumSamples);
+
+    // every lane passes straight through until the first setCrossovers
+    for (auto& group : sections)
+        for (auto& section : group)
+            for (size_t lane = 0; lane < Register::size(); ++lane)
+                setSection (section, lane, { 1.0, 0.0, 0.0, 0.0, 0.0 });
+
+    sampleRate = 0;
+    numBands = 1;
+    reset();
+}
+
+template <typename SampleType>
+void BandSplitter<SampleType>::reset() noexcept
+{
+    std::fill (channelStates.begin(), channelStates.end(), GroupState());
+    rampDrives = rampLevels = false;
+}
+
+template <typename SampleType>
+void BandSplitter<SampleType>::setSection (Section& section, size_t lane, const std::array<double, 5>& coefficients) noexcept
+{
+    section.b0.set (lane, (SampleType) coefficients[0]);
+    section.b1.set (lane, (SampleType) coefficients[1]);
+    section.b2.set (lane, (SampleType) coefficients[2]);
+    section.a1.set (lane, (SampleType) coefficients[3]);
+    section.a2.set (lane, (SampleType) coefficients[4]);
+}
+
+template <typename SampleType>
+void BandSplitter<SampleType>::setCrossovers (const std::array<float, maxBands - 1>& newFrequencies, int newNumBands, double newSampleRate) noexcept
+{
+    newNumBands = juce::jlimit (1, maxBands, newNumBands);
+
+    // keep the crossovers in order and clear of nyquist
+    std::array<float, numCrossovers> ordered;
+    auto lowest = 10.0f;
+
+    for (size_t i = 0; i < ordered.size(); ++i)
+        lowest = ordered[i] = juce::jlimit (lowest, (float) (0.45 * newSampleRate), newFrequencies[i]);
+
+    if (ordered == frequencies && newNumBands == numBands && newSampleRate == sampleRate)
+        return;
+
+    // the lanes mean something else with a different number of bands, so don't carry their state over
+    if (newNumBands != numBands)
+        reset();
+
+    frequencies = ordered;
+    numBands = newNumBands;
+    sampleRate = newSampleRate;
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        for (size_t lane = 0; lane < Register::size(); ++lane)
+        {
+            auto band = group * (int) Register::size() + (int) lane;
+
+            for (int crossover = 0; crossover < numCrossovers; ++crossover)
+            {
+                for (int section = 0; section < 2; ++section)
+                {
+                    auto& target = sections[group][2 * crossover + section];
+
+                    if (band >= numBands || crossover >= numBands - 1)
+                    {
+                        setSection (target, lane, { 1.0, 0.0, 0.0, 0.0, 0.0 });
+                        continue;
+                    }
+
+                    auto response = crossover < band  ? CrossoverResponse::highPass
+                                  : crossover == band ? CrossoverResponse::lowPass
+                                                      : CrossoverResponse::allPass;
+
+                    setSection (target, lane, makeCrossoverSection (response, section, frequencies[(size_t) crossover], sampleRate));
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void BandSplitter<SampleType>::split (const juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& newDrives) noexcept
+{
+    const auto numLanes = Register::size();
+    const auto numSamples = block.getNumSamples();
+
+    splitInterleaved (block, newDrives);
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* laneSamples = reinterpret_cast<const SampleType*> (interleaved.getChannelPointer (channel * (size_t) numGroups + (size_t) group));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                auto band = group * (int) numLanes + (int) lane;
+
+                if (band >= numBands)
+                    break;
+
+                auto* destination = bandBuffer.getWritePointer (band * numChannels + (int) channel);
+
+                for (size_t sample = 0; sample < numSamples; ++sample)
+                    destination[sample] = laneSamples[sample * numLanes + lane];
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void BandSplitter<SampleType>::splitInterleaved (const juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& newDrives) noexcept
+{
+    const auto numLanes = Register::size();
+    const auto numSamples = block.getNumSamples();
+    const auto numActiveSections = 2 * (numBands - 1);
+
+    jassert ((int) block.getNumChannels() <= numChannels);
+    jassert (numSamples <= interleaved.getNumSamples());
+
+    numSplitChannels = (int) block.getNumChannels();
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        Register target;
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            auto band = (size_t) group * numLanes + lane;
+            target.set (lane, band < (size_t) maxBands ? newDrives[band] : SampleType (0));
+        }
+
+        if (! rampDrives)
+            drives[group] = target;
+
+        auto step = (target - drives[group]) * Register::expand (SampleType (1) / (SampleType) juce::jmax ((size_t) 1, numSamples));
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            const auto& groupSections = sections[group];
+            auto& state = channelStates[channel * (size_t) numGroups + (size_t) group];
+            auto* input = block.getChannelPointer (channel);
+            auto* lanes = interleaved.getChannelPointer (channel * (size_t) numGroups + (size_t) group);
+            auto drive = drives[group];
+
+            for (size_t sample = 0; sample < numSamples; ++sample)
+            {
+                // the same input in every lane, then each lane's own chain of sections
+                auto x = Register::expand (input[sample]);
+
+                for (int s = 0; s < numActiveSections; ++s)
+                {
+                    const auto& c = groupSections[s];
+                    auto y = c.b0 * x + state.s1[s];
+                    state.s1[s] = c.b1 * x - c.a1 * y + state.s2[s];
+                    state.s2[s] = c.b2 * x - c.a2 * y;
+                    x = y;
+                }
+
+                drive += step;
+                lanes[sample] = x * drive;
+            }
+        }
+
+        drives[group] = target;
+    }
+
+    rampDrives = true;
+}
+
+template <typename SampleType>
+juce::dsp::AudioBlock<SampleType> BandSplitter<SampleType>::getBand (int band, size_t numSamples) noexcept
+{
+    jassert (juce::isPositiveAndBelow (band, numBands));
+
+    return juce::dsp::AudioBlock<SampleType> (bandBuffer).getSubsetChannelBlock ((size_t) (band * numChannels), (size_t) numChannels)
+                                                         .getSubBlock (0, numSamples);
+}
+
+template <typename SampleType>
+void BandSplitter<SampleType>::sum (juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& newLevels) noexcept
+{
+    const auto numSamples = (int) block.getNumSamples();
+
+    if (! rampLevels)
+        levels = newLevels;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto bandBlock = getBand (band, (size_t) numSamples);
+        auto start = levels[(size_t) band], target = newLevels[(size_t) band];
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* output = block.getChannelPointer (channel);
+            auto* input = bandBlock.getChannelPointer (channel);
+
+            if (start == target)
+            {
+                if (band == 0)
+                    juce::FloatVectorOperations::copyWithMultiply (output, input, target, numSamples);
+                else
+                    juce::FloatVectorOperations::addWithMultiply (output, input, target, numSamples);
+
+                continue;
+            }
+
+            auto step = (target - start) / (SampleType) numSamples;
+            auto level = start;
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                level += step;
+                output[sample] = (band == 0 ? SampleType (0) : output[sample]) + input[sample] * level;
+            }
+        }
+
+        levels[(size_t) band] = target;
+    }
+
+    rampLevels = true;
+}
+
+template <typename SampleType>
+void BandSplitter<SampleType>::sumInterleaved (juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& newLevels) noexcept
+{
+    const auto numLanes = Register::size();
+    const auto numSamples = block.getNumSamples();
+
+    if (! rampLevels)
+        levels = newLevels;
+
+    for (int group = 0; group * (int) numLanes < numBands; ++group)
+    {
+        // the spare lanes get a level of 0, so the split's passthrough in them drops out
+        Register start, target;
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            auto band = (size_t) group * numLanes + lane;
+            auto inUse = band < (size_t) numBands;
+            start.set (lane, inUse ? levels[band] : SampleType (0));
+            target.set (lane, inUse ? newLevels[band] : SampleType (0));
+        }
+
+        auto step = (target - start) * Register::expand (SampleType (1) / (SampleType) juce::jmax ((size_t) 1, numSamples));
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* output = block.getChannelPointer (channel);
+            auto* lanes = interleaved.getChannelPointer (channel * (size_t) numGroups + (size_t) group);
+            auto level = start;
+
+            for (size_t sample = 0; sample < numSamples; ++sample)
+            {
+                level += step;
+                auto bands = (lanes[sample] * level).sum();
+                output[sample] = group == 0 ? bands : output[sample] + bands;
+            }
+        }
+    }
+
+    for (int band = 0; band < numBands; ++band)
+        levels[(size_t) band] = newLevels[(size_t) band];
+
+    rampLevels = true;
+}
+
+//==============================================================================
+template class BandSplitter<float>;
+template class BandSplitter<double>;
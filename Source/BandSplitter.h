@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    BandSplitter.h
+
+    Splits a block into 2 to 4 Linkwitz-Riley bands for the multiband mode,
+    with the bands in the lanes of a juce::dsp::SIMDRegister. Every input
+    sample is broadcast to all the lanes and each lane runs its own band's
+    chain, so all the bands cost one pass over the buffer rather than one
+    pass each.
+
+    Band b is the lowpass of crossover b, the highpass of every crossover
+    below it and the allpass of every crossover above it. Those allpasses
+    line the phases up so the bands sum back to a flat response, the same
+    as splitting the bands off one at a time with a tree of crossovers.
+
+    The bands can stay in their lanes for shaping too. A shaper that treats
+    every sample alike then runs over all of them in one call per channel,
+    instead of once per band, and the sum reads them straight from the lanes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename SampleType>
+class BandSplitter
+{
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int maxBands = 4;
+
+    BandSplitter() = default;
+
+    /** Allocates the band buffers and the filter state for numChannels of up to maximumSamples. */
+    void prepare (int numChannels, int maximumSamples);
+    void reset() noexcept;
+
+    /** Sets the crossover frequencies, lowest first. Only recomputes the coefficients when
+        something has changed, and never allocates, so it's fine to call every block.
+    */
+    void setCrossovers (const std::array<float, maxBands - 1>& frequencies, int numBands, double sampleRate) noexcept;
+
+    /** Splits every channel of the block into the bands, scaling each band by its drive. The
+        drives ramp from their last values across the block.
+    */
+    void split (const juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& drives) noexcept;
+
+    /** One band of every channel, valid after split. */
+    juce::dsp::AudioBlock<SampleType> getBand (int band, size_t numSamples) noexcept;
+
+    /** The same as split, but leaves the bands interleaved in their lanes for shapeInterleaved and sumInterleaved. */
+    void splitInterleaved (const juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& drives) noexcept;
+
+    /** Runs shapeValues (SampleType* data, int numValues, int shaperType) in place over the interleaved
+        bands. Where all of a register's bands use one shaper that's a single call per channel. Otherwise
+        it's one call per shaper on a copy, and each lane keeps the result for its own band's shaper.
+    */
+    template <typename ShapeFunction>
+    void shapeInterleaved (const std::array<int, maxBands>& shaperTypes, size_t numSamples, ShapeFunction&& shapeValues) noexcept;
+
+    /** Replaces the block with the sum of the interleaved bands, the same as sum. */
+    void sumInterleaved (juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& levels) noexcept;
+
+    /** Replaces the block with the sum of the bands, each scaled by its level. The levels
+        ramp from their last values across the block.
+    */
+    void sum (juce::dsp::AudioBlock<SampleType>& block, const std::array<SampleType, maxBands>& levels) noexcept;
+
+    int getNumBands() const noexcept     { return numBands; }
+
+private:
+    // the bands are spread over this many registers, 1 for float and 2 for double with SSE / NEON
+    static constexpr int numGroups = (maxBands + (int) Register::size() - 1) / (int) Register::size();
+    static constexpr int numCrossovers = maxBands - 1;
+
+    // a Linkwitz-Riley lowpass, highpass or allpass is two biquads, and every lane has its own coefficients
+    static constexpr int numSections = 2 * numCrossovers;
+
+    struct Section
+    {
+        Register b0, b1, b2, a1, a2;
+    };
+
+    // transposed direct form II state of every section
+    struct GroupState
+    {
+        Register s1[numSections], s2[numSections];
+    };
+
+    static void setSection (Section& section, size_t lane, const std::array<double, 5>& coefficients) noexcept;
+
+    Section sections[numGroups][numSections];
+    std::vector<GroupState> channelStates;
+
+    // the bands' drives and levels at the end of the last block, where the next ramps start
+    Register drives[numGroups];
+    std::array<SampleType, maxBands> levels {};
+
+    // off after a reset, so the first block starts at its settings instead of ramping to them
+    bool rampDrives = false, rampLevels = false;
+
+    // the split bands, band b of channel c is channel b * numChannels + c
+    juce::AudioBuffer<SampleType> bandBuffer;
+
+    // the bands in their lanes, group g of channel c is channel c * numGroups + g. The scratch holds
+    // the unshaped lanes and one shaper's result while a group's bands use different shapers
+    juce::HeapBlock<char> interleavedData, scratchData;
+    juce::dsp::AudioBlock<Register> interleaved, scratch;
+    int numSplitChannels = 0;
+
+    std::array<float, numCrossovers> frequencies {};
+    double sampleRate = 0;
+    int numBands = 1, numChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandSplitter)
+};
+
+//==============================================================================
+template <typename SampleType>
+template <typename ShapeFunction>
+void BandSplitter<SampleType>::shapeInterleaved (const std::array<int, maxBands>& shaperTypes, size_t numSamples,
+                                                 ShapeFunction&& shapeValues) noexcept
+{
+    const auto numLanes = Register::size();
+    const auto numValues = (int) (numSamples * numLanes);
+
+    // a group with no bands in it only holds the split's passthrough, which sumInterleaved drops
+    for (int group = 0; group * (int) numLanes < numBands; ++group)
+    {
+        // the shapers this group's bands use, and which lanes each one is for
+        std::array<int, maxBands> groupTypes;
+        std::array<Register, maxBands> laneWeights;
+        int numTypes = 0;
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            auto band = group * (int) numLanes + (int) lane;
+
+            if (band >= numBands)
+                break;
+
+            auto type = shaperTypes[(size_t) band];
+            auto index = (int) (std::find (groupTypes.begin(), groupTypes.begin() + numTypes, type) - groupTypes.begin());
+
+            if (index == numTypes)
+            {
+                groupTypes[(size_t) numTypes] = type;
+                laneWeights[(size_t) numTypes] = Register::expand (SampleType (0));
+                ++numTypes;
+            }
+
+            laneWeights[(size_t) index].set (lane, SampleType (1));
+        }
+
+        for (int channel = 0; channel < numSplitChannels; ++channel)
+        {
+            auto* lanes = interleaved.getChannelPointer ((size_t) (channel * numGroups + group));
+
+            if (numTypes == 1)
+            {
+                shapeValues (reinterpret_cast<SampleType*> (lanes), numValues, groupTypes[0]);
+                continue;
+            }
+
+            // weights of 1 and 0 pick each lane's result exactly, every shaper is finite for finite input
+            auto* unshaped = scratch.getChannelPointer (0);
+            auto* shaped = scratch.getChannelPointer (1);
+            std::copy (lanes, lanes + numSamples, unshaped);
+
+            for (int type = 0; type < numTypes; ++type)
+            {
+                std::copy (unshaped, unshaped + numSamples, shaped);
+                shapeValues (reinterpret_cast<SampleType*> (shaped), numValues, groupTypes[(size_t) type]);
+
+                const auto weight = laneWeights[(size_t) type];
+
+                for (size_t sample = 0; sample < numSamples; ++sample)
+                    lanes[sample] = (type == 0 ? Register::expand (SampleType (0)) : lanes[sample]) + shaped[sample] * weight;
+            }
+        }
+    }
+}
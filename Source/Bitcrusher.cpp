@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    Bitcrusher.cpp
+
+  ==============================================================================
+*/
+
+#include "Bitcrusher.h"
+
+//==============================================================================
+template <typename SampleType>
+Bitcrusher<SampleType>::Bitcrusher()
+    : kernels (DistortionKernels::getKernels<SampleType>())
+{
+}
+
+template <typename SampleType>
+void Bitcrusher<SampleType>::prepare (int numChannels)
+{
+    channelStates.resize ((size_t) numChannels);
+    reset();
+}
+
+template <typename SampleType>
+void Bitcrusher<SampleType>::reset() noexcept
+{
+    for (size_t channel = 0; channel < channelStates.size(); ++channel)
+    {
+        channelStates[channel] = ChannelState();
+        channelStates[channel].dither.seed ((juce::uint32) channel);
+    }
+
+    holdPhase = 0;
+}
+
+template <typename SampleType>
+void Bitcrusher<SampleType>::process (juce::dsp::AudioBlock<SampleType>& block, float bits, float downsampling, bool dither) noexcept
+{
+    jassert (block.getNumChannels() <= channelStates.size());
+
+    auto numSamples = (int) block.getNumSamples();
+    auto period = (SampleType) juce::jmax (1.0f, downsampling);
+    auto levels = (SampleType) std::exp2 (juce::jmax (1.0f, bits) - 1.0f);
+    auto endPhase = holdPhase;
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* channelData = block.getChannelPointer (channel);
+        auto& state = channelStates[channel];
+
+        if (period > SampleType (1))
+        {
+            // take a new sample each time the phase passes the period, written as selects
+            // rather than branches so the loop stays a straight run of cmovs
+            auto phase = holdPhase;
+            auto held = state.held;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                phase += SampleType (1);
+                auto take = phase >= period;
+                held = take ? channelData[i] : held;
+                phase -= take ? period : SampleType (0);
+                channelData[i] = held;
+            }
+
+            state.held = held;
+            endPhase = phase;
+        }
+
+        if (bits < maxBits)
+            kernels.quantise (channelData, numSamples, levels, dither ? SampleType (1) : SampleType (0), state.dither);
+    }
+
+    holdPhase = endPhase;
+}
+
+//==============================================================================
+template class Bitcrusher<float>;
+template class Bitcrusher<double>;
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    Bitcrusher.h
+
+    Bit depth and sample rate reduction. The rate reduction is a sample and
+    hold with a fractional period, the bit reduction rounds to a grid of
+    2^(bits - 1) steps per unit with optional triangular dither, using the
+    SSE / NEON quantise kernels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DistortionKernels.h"
+
+template <typename SampleType>
+class Bitcrusher
+{
+public:
+    /** At or past these settings the stage does nothing and is skipped. */
+    static constexpr float maxBits = 24.0f;
+
+    static bool isActive (float bits, float downsampling) noexcept
+    {
+        return bits < maxBits || downsampling > 1.0f;
+    }
+
+    Bitcrusher();
+
+    /** Allocates the per-channel hold and dither state. */
+    void prepare (int numChannels);
+    void reset() noexcept;
+
+    /** Crushes every channel of the block in place. bits can be fractional, downsampling
+        is how many samples each held value lasts and can be fractional too.
+    */
+    void process (juce::dsp::AudioBlock<SampleType>& block, float bits, float downsampling, bool dither) noexcept;
+
+private:
+    struct ChannelState
+    {
+        SampleType held = 0;
+        DistortionKernels::DitherState dither;
+    };
+
+    std::vector<ChannelState> channelStates;
+
+    // one phase for every channel so the channels stay sample-aligned
+    SampleType holdPhase = 0;
+
+    const DistortionKernels::Kernels<SampleType>& kernels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Bitcrusher)
+};
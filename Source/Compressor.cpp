@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    Compressor.cpp
+
+  ==============================================================================
+*/
+
+#include "Compressor.h"
+
+//==============================================================================
+template <typename SampleType>
+void Compressor<SampleType>::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    channelStates.resize ((size_t) spec.numChannels);
+
+    // the RMS window is fixed, the attack and release shape the gain instead
+    rmsCoefficient = (float) std::exp (-1.0 / (0.01 * sampleRate));
+
+    attackMs = releaseMs = -1.0f;
+    reset();
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::reset() noexcept
+{
+    std::fill (channelStates.begin(), channelStates.end(), ChannelState());
+    maxReduction = 0;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateCoefficients (const CompressorSettings& settings) noexcept
+{
+    if (settings.attackMs != attackMs)
+    {
+        attackMs = settings.attackMs;
+        attackCoefficient = (float) std::exp (-1.0 / (juce::jmax (0.01, (double) attackMs) * 0.001 * sampleRate));
+    }
+
+    if (settings.releaseMs != releaseMs)
+    {
+        releaseMs = settings.releaseMs;
+        releaseCoefficient = (float) std::exp (-1.0 / (juce::jmax (0.01, (double) releaseMs) * 0.001 * sampleRate));
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::process (juce::dsp::AudioBlock<SampleType>& block, const CompressorSettings& settings) noexcept
+{
+    jassert (block.getNumChannels() <= channelStates.size());
+
+    updateCoefficients (settings);
+
+    const auto numChannels = block.getNumChannels();
+    const auto numSamples = block.getNumSamples();
+
+    // everything below is in log2 units, so dB thresholds and gains are scaled once here
+    const auto threshold = settings.thresholdDecibels / FastMath::decibelsPerLog2;
+    const auto makeup = settings.makeupDecibels / FastMath::decibelsPerLog2;
+    const auto slope = 1.0f / juce::jmax (1.0f, settings.ratio) - 1.0f;
+    const auto link = juce::jlimit (0.0f, 1.0f, settings.link);
+
+    auto blockReduction = 0.0f;
+
+    for (size_t sample = 0; sample < numSamples; ++sample)
+    {
+        auto loudest = -1000.0f;
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = channelStates[channel];
+            auto x = (float) block.getSample ((int) channel, (int) sample);
+
+            if (settings.rms)
+            {
+                state.meanSquare = x * x + rmsCoefficient * (state.meanSquare - x * x);
+                state.level = 0.5f * FastMath::fastLog2 (state.meanSquare);
+            }
+            else
+            {
+                state.level = FastMath::fastLog2 (std::abs (x));
+            }
+
+            loudest = juce::jmax (loudest, state.level);
+        }
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto& state = channelStates[channel];
+
+            // the static curve, then attack when the reduction deepens and release when it recovers
+            auto level = state.level + link * (loudest - state.level);
+            auto target = juce::jmin (0.0f, (level - threshold) * slope);
+            auto coefficient = target < state.reduction ? attackCoefficient : releaseCoefficient;
+            state.reduction = target + coefficient * (state.reduction - target);
+
+            blockReduction = juce::jmin (blockReduction, state.reduction);
+
+            auto* channelData = block.getChannelPointer (channel);
+            channelData[sample] *= (SampleType) FastMath::fastExp2 (state.reduction + makeup);
+        }
+    }
+
+    maxReduction = blockReduction;
+}
+
+//==============================================================================
+template class Compressor<float>;
+template class Compressor<double>;
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    Compressor.h
+
+    A feed-forward compressor for either side of the shaper. Levels and gain
+    are worked out in the log2 domain with FastMath, so the sample loop has no
+    log, pow or exp calls. The detector is peak or RMS, and linking blends each
+    channel's level towards the loudest channel's.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FastMath.h"
+
+struct CompressorSettings
+{
+    float thresholdDecibels = 0.0f, ratio = 1.0f, makeupDecibels = 0.0f;
+    float attackMs = 10.0f, releaseMs = 100.0f;
+
+    /** 0 compresses every channel on its own, 1 compresses them all by the loudest. */
+    float link = 1.0f;
+    bool rms = false;
+
+    /** At 1:1 the compressor does nothing and is skipped. */
+    bool isActive() const noexcept     { return ratio > 1.0f; }
+};
+
+template <typename SampleType>
+class Compressor
+{
+public:
+    Compressor() = default;
+
+    /** Allocates the per-channel detector state. */
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    /** Compresses every channel of the block in place. */
+    void process (juce::dsp::AudioBlock<SampleType>& block, const CompressorSettings& settings) noexcept;
+
+    /** The deepest gain reduction in the last block, as a positive number of dB. */
+    float getGainReductionDecibels() const noexcept     { return -maxReduction * FastMath::decibelsPerLog2; }
+
+private:
+    void updateCoefficients (const CompressorSettings& settings) noexcept;
+
+    struct ChannelState
+    {
+        float meanSquare = 0;       // the RMS detector's running mean of x^2
+        float reduction = 0;        // smoothed gain reduction, log2 units, <= 0
+        float level = 0;            // this sample's detector level, log2 units
+    };
+
+    std::vector<ChannelState> channelStates;
+    double sampleRate = 44100.0;
+
+    // one-pole coefficients, only recomputed when the times change
+    float attackMs = -1.0f, releaseMs = -1.0f;
+    float attackCoefficient = 0, releaseCoefficient = 0, rmsCoefficient = 0;
+
+    float maxReduction = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Compressor)
+};
@@ -0,0 +1,681 @@
+/*
+  ==============================================================================
+
+    DistortionEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "DistortionEngine.h"
+
+FilterCoefficients FilterCoefficients::make (double sampleRate, float cutoff, float lowcut, int numSections, float resonance) noexcept
+{
+    FilterCoefficients coefficients;
+    numSections = juce::jlimit (1, BiquadCascade::maxSections, numSections);
+    coefficients.lowPass.numSections = coefficients.highPass.numSections = numSections;
+
+    // the bilinear transforms makeLowPass and makeHighPass use, without the objects they allocate.
+    // Both frequencies stay below Nyquist whatever the host rate
+    auto nyquist = sampleRate * 0.49;
+    auto lowPassN = 1.0 / std::tan (juce::MathConstants<double>::pi * juce::jmin ((double) cutoff, nyquist) / sampleRate);
+    auto highPassN = std::tan (juce::MathConstants<double>::pi * juce::jmin ((double) lowcut, nyquist) / sampleRate);
+
+    for (int section = 0; section < numSections; ++section)
+    {
+        // the Butterworth pole pairs of an order 2n filter, from the flattest up to the sharpest
+        auto order = 2 * numSections;
+        auto q = 1.0 / (2.0 * std::cos (juce::MathConstants<double>::pi * (2 * section + 1) / (2.0 * order)));
+
+        // the sharpest section carries the resonance. It's relative to a single section's flat
+        // Q of 1 / sqrt 2, so a resonance of 1 at 12 dB/oct is the Q of 1 this filter always had
+        if (section == numSections - 1)
+            q *= resonance * juce::MathConstants<double>::sqrt2;
+
+        auto lowPass = 1.0 / (1.0 + lowPassN / q + lowPassN * lowPassN);
+        coefficients.lowPass.sections[(size_t) section] = {{ lowPass, 2.0 * lowPass, lowPass,
+                                                             lowPass * 2.0 * (1.0 - lowPassN * lowPassN),
+                                                             lowPass * (1.0 - lowPassN / q + lowPassN * lowPassN) }};
+
+        auto highPass = 1.0 / (1.0 + highPassN / q + highPassN * highPassN);
+        coefficients.highPass.sections[(size_t) section] = {{ highPass, -2.0 * highPass, highPass,
+                                                              highPass * 2.0 * (highPassN * highPassN - 1.0),
+                                                              highPass * (1.0 - highPassN / q + highPassN * highPassN) }};
+    }
+
+    return coefficients;
+}
+
+//==============================================================================
+template <typename SampleType>
+DistortionEngine<SampleType>::DistortionEngine()
+    : shaperKernels (DistortionKernels::getKernels<SampleType>())
+{
+    stateVariableLowPass.setType (juce::dsp::StateVariableTPTFilterType::lowpass);
+    stateVariableHighPass.setType (juce::dsp::StateVariableTPTFilterType::highpass);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::prepare (const juce::dsp::ProcessSpec& spec, const DistortionParameters& params)
+{
+    sampleRate = spec.sampleRate;
+
+    lowPassLanes.prepare (spec);
+    highPassLanes.prepare (spec);
+
+    stateVariableLowPass.prepare (spec);
+    stateVariableHighPass.prepare (spec);
+
+    cutoffFrequency.reset (spec.sampleRate, 0.02);
+    lowcutFrequency.reset (spec.sampleRate, 0.02);
+    cutoffFrequency.setCurrentAndTargetValue ((SampleType) params.cutoff);
+    lowcutFrequency.setCurrentAndTargetValue ((SampleType) params.lowcut);
+    tunedSections = 0;
+    retuneBiquads (params);
+    stateVariableLowPass.setCutoffFrequency ((SampleType) params.cutoff);
+    stateVariableHighPass.setCutoffFrequency ((SampleType) params.lowcut);
+    stateVariableFiltersActive = params.stateVariableFilters;
+
+    // the dry buffer lives in the mixer, size it here for the largest block and every channel
+    dryWetMixer.prepare (spec);
+    dryWetMixer.setMixingRule (juce::dsp::DryWetMixingRule::linear);
+    dryWetMixer.setWetMixProportion ((SampleType) params.mix);
+
+    // ramps start at the current settings so playback doesn't open with a fade
+    for (auto* gain : { &inputGain, &driveGain, &outputGain })
+        gain->reset (spec.sampleRate, 0.05);
+
+    gainRamp.allocate (spec.maximumBlockSize, true);
+
+    inputGain.setCurrentAndTargetValue ((SampleType) params.inputGain);
+    driveGain.setCurrentAndTargetValue ((SampleType) params.drive);
+    outputGain.setCurrentAndTargetValue ((SampleType) params.outputGain);
+
+    oversamplers.clear();
+
+    for (auto filterType : { juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+                             juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple })
+    {
+        for (int factor = 1; factor <= maxOversamplingFactor; ++factor)
+        {
+            auto* oversampler = oversamplers.add (new juce::dsp::Oversampling<SampleType> (spec.numChannels, (size_t) factor, filterType, true, true));
+            oversampler->initProcessing ((size_t) spec.maximumBlockSize);
+        }
+    }
+
+    adaaShaper.prepare ((int) spec.numChannels);
+
+    // the bands are split at the oversampled rate, so they need room for the largest factor
+    bandSplitter.prepare ((int) spec.numChannels, (int) spec.maximumBlockSize << maxOversamplingFactor);
+
+    for (auto& shaper : bandShapers)
+        shaper.prepare ((int) spec.numChannels);
+
+    activeBands = params.numBands;
+    bitcrusher.prepare ((int) spec.numChannels);
+    compressor.prepare (spec);
+
+    // the convolution handles mono and stereo, wider layouts go without the cabinet
+    cabinetSupported = spec.numChannels <= 2;
+    cabinetBuffer.setSize ((int) spec.numChannels, (int) spec.maximumBlockSize);
+    cabinetLength = 0;
+
+    {
+        const juce::ScopedLock sl (cabinetLock);
+        cabinet.prepare (spec);
+        cabinetRate = spec.sampleRate;
+        cabinetPendingLength = 0;
+        prepared = true;
+
+        // the prepared convolution starts empty, so the response goes back in if it suits this rate
+        submitCabinet();
+    }
+
+    currentOversampler = -2;
+    wetLatency = -1;
+    setOversampler (params.oversampler);
+    setWetLatency (params.antialiasing);
+    reset();
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::reset() noexcept
+{
+    lowPassLanes.reset();
+    highPassLanes.reset();
+    stateVariableLowPass.reset();
+    stateVariableHighPass.reset();
+    dryWetMixer.reset();
+    adaaShaper.reset();
+    bandSplitter.reset();
+
+    for (auto& shaper : bandShapers)
+        shaper.reset();
+
+    bitcrusher.reset();
+    compressor.reset();
+    cabinet.reset();
+
+    for (auto* oversampler : oversamplers)
+        oversampler->reset();
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::jumpTo (const DistortionParameters& params) noexcept
+{
+    setOversampler (params.oversampler);
+    setWetLatency (params.antialiasing);
+
+    cutoffFrequency.setCurrentAndTargetValue ((SampleType) params.cutoff);
+    lowcutFrequency.setCurrentAndTargetValue ((SampleType) params.lowcut);
+    retuneBiquads (params);
+    stateVariableLowPass.setCutoffFrequency ((SampleType) params.cutoff);
+    stateVariableHighPass.setCutoffFrequency ((SampleType) params.lowcut);
+    stateVariableFiltersActive = params.stateVariableFilters;
+
+    inputGain.setCurrentAndTargetValue ((SampleType) params.inputGain);
+    driveGain.setCurrentAndTargetValue ((SampleType) params.drive);
+    outputGain.setCurrentAndTargetValue ((SampleType) params.outputGain);
+
+    // the mixer's own ramp lands on the new mix when it's reset below
+    dryWetMixer.setWetMixProportion ((SampleType) params.mix);
+    reset();
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::setOversampler (int index) noexcept
+{
+    if (index == currentOversampler)
+        return;
+
+    currentOversampler = index;
+
+    // the oversamplers are built with integer latency, so this rounding is exact
+    if (auto* oversampler = oversamplers[currentOversampler])
+    {
+        oversampler->reset();
+        latency = juce::roundToInt (oversampler->getLatencyInSamples());
+    }
+    else
+    {
+        latency = 0;
+    }
+
+    jassert (latency <= maxOversamplingLatency);
+    latency = juce::jmin (latency, maxOversamplingLatency);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::setWetLatency (int antialiasing) noexcept
+{
+    // ADAA runs at the oversampled rate, so its delay shrinks with the oversampling factor
+    auto* oversampler = oversamplers[currentOversampler];
+    auto factor = oversampler != nullptr ? (double) oversampler->getOversamplingFactor() : 1.0;
+    auto newWetLatency = (SampleType) (latency + ADAAShaper<SampleType>::getDelaySamples (antialiasing) / factor);
+
+    // delay the dry path by the same amount as the wet one
+    if (newWetLatency != wetLatency)
+    {
+        wetLatency = newWetLatency;
+        dryWetMixer.setWetLatency (wetLatency);
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void DistortionEngine<SampleType>::process (juce::dsp::AudioBlock<SampleType> block, const DistortionParameters& params) noexcept
+{
+    auto numSamples = (int) block.getNumSamples();
+
+    // a clock read at each stage boundary, a handful per block whatever its size
+    ProcessingStats::StageClock clock (lastTiming, sampleRate, numSamples);
+
+    // switching oversampler changes the latency, the processor reports it to the host
+    setOversampler (params.oversampler);
+    setWetLatency (params.antialiasing);
+
+    // keep a copy of the dry signal for the mix stage, the mixer's buffer is sized in prepare
+    // so this works for any channel layout without allocating on the audio thread
+    dryWetMixer.pushDrySamples (block);
+    clock.lap (ProcessingStats::mix);
+
+    if (params.compressBeforeShaper)
+    {
+        processCompressor (block, params);
+        clock.lap (ProcessingStats::dynamics);
+    }
+
+    // input volume and drive are both linear gains ahead of the curve, so they're ramped together
+    // here and the shaper runs with a drive of 1
+    inputGain.setTargetValue ((SampleType) params.inputGain);
+    driveGain.setTargetValue ((SampleType) params.drive);
+
+    if (inputGain.isSmoothing() || driveGain.isSmoothing())
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+            gainRamp[sample] = inputGain.getNextValue() * driveGain.getNextValue();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::multiply (block.getChannelPointer (channel), gainRamp, numSamples);
+    }
+    else
+    {
+        block.multiplyBy (inputGain.getTargetValue() * driveGain.getTargetValue());
+    }
+
+    clock.lap (ProcessingStats::gain);
+
+    if (params.crushBeforeShaper)
+    {
+        processBitcrusher (block, params);
+        clock.lap (ProcessingStats::dynamics);
+    }
+
+    processShaper (block, params);
+    clock.lap (ProcessingStats::shaper);
+
+    if (! params.crushBeforeShaper)
+        processBitcrusher (block, params);
+
+    if (! params.compressBeforeShaper)
+        processCompressor (block, params);
+
+    clock.lap (ProcessingStats::dynamics);
+
+    outputGain.setTargetValue ((SampleType) params.outputGain);
+
+    if (outputGain.isSmoothing())
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+            gainRamp[sample] = outputGain.getNextValue();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::multiply (block.getChannelPointer (channel), gainRamp, numSamples);
+    }
+    else if (outputGain.getTargetValue() != SampleType (1))
+    {
+        block.multiplyBy (outputGain.getTargetValue());
+    }
+    clock.lap (ProcessingStats::gain);
+
+    processFilters (block, params);
+    clock.lap (ProcessingStats::filters);
+
+    if (! cabinetWanted)
+    {
+        cabinetLength = 0;
+    }
+    else if (params.cabinet && cabinetSupported)
+    {
+        processCabinet (block);
+        clock.lap (ProcessingStats::cabinet);
+    }
+
+    // mixing bewtween dry signal and processed signal, the mixer ramps this internally
+    dryWetMixer.setWetMixProportion ((SampleType) params.mix);
+    dryWetMixer.mixWetSamples (block);
+    clock.lap (ProcessingStats::mix);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processShaper (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    // https://www.youtube.com/watch?v=oIChUOV_0w4
+    // compression at 23:13
+    // bitcrushing at 29:00
+
+    auto* oversampler = oversamplers[currentOversampler];
+
+    // apply distortion processing to channel data, split into bands first in the multiband mode
+    auto shaperBlock = oversampler != nullptr ? oversampler->processSamplesUp (block) : block;
+
+    if (params.numBands > 1)
+    {
+        processBands (shaperBlock, params);
+    }
+    else
+    {
+        // the single shaper's ADAA history went stale while the bands were running
+        if (activeBands > 1)
+            adaaShaper.reset();
+
+        shapeBlock (shaperBlock, params.shaper, params, adaaShaper);
+    }
+
+    activeBands = params.numBands;
+
+    if (oversampler != nullptr)
+        oversampler->processSamplesDown (block);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processBands (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    // coming from the single shaper or a different band count, start every band from silence
+    if (params.numBands != activeBands)
+    {
+        bandSplitter.reset();
+
+        for (auto& shaper : bandShapers)
+            shaper.reset();
+    }
+
+    auto* oversampler = oversamplers[currentOversampler];
+    auto factor = oversampler != nullptr ? (double) oversampler->getOversamplingFactor() : 1.0;
+    bandSplitter.setCrossovers (params.crossovers, params.numBands, sampleRate * factor);
+
+    std::array<SampleType, BandSplitter<SampleType>::maxBands> drives, levels;
+
+    for (size_t band = 0; band < drives.size(); ++band)
+    {
+        drives[band] = (SampleType) params.bands[band].drive;
+        levels[band] = (SampleType) params.bands[band].level;
+    }
+
+    // one pass splits every band with its drive applied. ADAA keeps a history per band, so it needs
+    // the bands pulled apart and shaped one at a time
+    if (params.antialiasing != ADAAShaper<SampleType>::off)
+    {
+        bandSplitter.split (block, drives);
+
+        for (int band = 0; band < bandSplitter.getNumBands(); ++band)
+        {
+            auto bandBlock = bandSplitter.getBand (band, block.getNumSamples());
+            shapeBlock (bandBlock, params.bands[(size_t) band].shaper, params, bandShapers[band]);
+        }
+
+        bandSplitter.sum (block, levels);
+        return;
+    }
+
+    // the kernels and tables treat every sample alike, so they shape all the bands in their lanes at once
+    std::array<int, BandSplitter<SampleType>::maxBands> shaperTypes;
+
+    for (size_t band = 0; band < shaperTypes.size(); ++band)
+        shaperTypes[band] = params.bands[band].shaper;
+
+    bandSplitter.splitInterleaved (block, drives);
+    bandSplitter.shapeInterleaved (shaperTypes, block.getNumSamples(), [this, &params] (SampleType* data, int numValues, int shaperType)
+    {
+        shapeValues (data, numValues, shaperType, params);
+    });
+    bandSplitter.sumInterleaved (block, levels);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::shapeBlock (juce::dsp::AudioBlock<SampleType>& block, int shaperType, const DistortionParameters& params,
+                                               ADAAShaper<SampleType>& antialiasedShaper) noexcept
+{
+    if (params.antialiasing != ADAAShaper<SampleType>::off)
+    {
+        antialiasedShaper.process (block, shaperType, params.antialiasing);
+        return;
+    }
+
+    // a whole channel at a time so the shaper kernels can vectorise
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        shapeValues (block.getChannelPointer (channel), (int) block.getNumSamples(), shaperType, params);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::shapeValues (SampleType* data, int numValues, int shaperType, const DistortionParameters& params) noexcept
+{
+    // quality 0 is the direct kernels, 1 and up pick a table size. The kernels themselves have
+    // no per-sample branching on the algorithm
+    if (params.quality > 0)
+        shaperTables->get (shaperType, params.quality - 1).process (data, numValues, SampleType (1), params.cubicTable);
+    else
+        shaperKernels.shapers[shaperType] (data, numValues, SampleType (1));
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processBitcrusher (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    if (Bitcrusher<SampleType>::isActive (params.crushBits, params.downsampling))
+        bitcrusher.process (block, params.crushBits, params.downsampling, params.dither);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processCompressor (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    // at 1:1 there's nothing to do, so don't even run the detector
+    if (params.compressor.isActive())
+        compressor.process (block, params.compressor);
+    else if (compressorActive)
+        compressor.reset();
+
+    compressorActive = params.compressor.isActive();
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processFilters (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    if (params.stateVariableFilters)
+    {
+        processStateVariableFilters (block, params);
+    }
+    else
+    {
+        if (stateVariableFiltersActive)
+        {
+            lowPassLanes.reset();
+            highPassLanes.reset();
+        }
+
+        processBiquads (block, params);
+    }
+
+    stateVariableFiltersActive = params.stateVariableFilters;
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processBiquads (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    cutoffFrequency.setTargetValue ((SampleType) params.cutoff);
+    lowcutFrequency.setTargetValue ((SampleType) params.lowcut);
+
+    if (! cutoffFrequency.isSmoothing() && ! lowcutFrequency.isSmoothing())
+    {
+        retuneBiquads (params);
+        lowPassLanes.process (block);
+        highPassLanes.process (block);
+        return;
+    }
+
+    // while a cutoff is moving, retune in short steps so a sweep doesn't zipper
+    for (size_t start = 0; start < block.getNumSamples(); start += biquadRetuneInterval)
+    {
+        auto length = juce::jmin (biquadRetuneInterval, block.getNumSamples() - start);
+        cutoffFrequency.skip ((int) length);
+        lowcutFrequency.skip ((int) length);
+        retuneBiquads (params);
+
+        auto subBlock = block.getSubBlock (start, length);
+        lowPassLanes.process (subBlock);
+        highPassLanes.process (subBlock);
+    }
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::retuneBiquads (const DistortionParameters& params) noexcept
+{
+    auto cutoff = cutoffFrequency.getCurrentValue();
+    auto lowcut = lowcutFrequency.getCurrentValue();
+
+    if (cutoff == tunedCutoff && lowcut == tunedLowcut && params.resonance == tunedResonance
+         && params.filterSections == tunedSections)
+        return;
+
+    tunedCutoff = cutoff;
+    tunedLowcut = lowcut;
+    tunedResonance = params.resonance;
+    tunedSections = params.filterSections;
+
+    auto coefficients = FilterCoefficients::make (sampleRate, (float) cutoff, (float) lowcut, params.filterSections, params.resonance);
+    lowPassLanes.setCoefficients (coefficients.lowPass);
+    highPassLanes.setCoefficients (coefficients.highPass);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processStateVariableFilters (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept
+{
+    // coming back from the biquads, start from silence and the current settings rather than stale state
+    if (! stateVariableFiltersActive)
+    {
+        stateVariableLowPass.reset();
+        stateVariableHighPass.reset();
+        cutoffFrequency.setCurrentAndTargetValue ((SampleType) params.cutoff);
+        lowcutFrequency.setCurrentAndTargetValue ((SampleType) params.lowcut);
+        stateVariableLowPass.setCutoffFrequency ((SampleType) params.cutoff);
+        stateVariableHighPass.setCutoffFrequency ((SampleType) params.lowcut);
+    }
+
+    cutoffFrequency.setTargetValue ((SampleType) params.cutoff);
+    lowcutFrequency.setTargetValue ((SampleType) params.lowcut);
+
+    // the same resonance as the biquads at 12 dB/oct
+    if (stateVariableLowPass.getResonance() != (SampleType) params.resonance)
+    {
+        stateVariableLowPass.setResonance ((SampleType) params.resonance);
+        stateVariableHighPass.setResonance ((SampleType) params.resonance);
+    }
+
+    if (! cutoffFrequency.isSmoothing() && ! lowcutFrequency.isSmoothing())
+    {
+        stateVariableLowPass.process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+        stateVariableHighPass.process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+        return;
+    }
+
+    // while a cutoff is moving, retune both filters every sample
+    for (size_t sample = 0; sample < block.getNumSamples(); ++sample)
+    {
+        stateVariableLowPass.setCutoffFrequency (cutoffFrequency.getNextValue());
+        stateVariableHighPass.setCutoffFrequency (lowcutFrequency.getNextValue());
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* channelData = block.getChannelPointer (channel);
+            channelData[sample] = stateVariableHighPass.processSample ((int) channel, stateVariableLowPass.processSample ((int) channel, channelData[sample]));
+        }
+    }
+
+    stateVariableLowPass.snapToZero();
+    stateVariableHighPass.snapToZero();
+}
+
+//==============================================================================
+template <typename SampleType>
+void DistortionEngine<SampleType>::setCabinet (ImpulseResponseLoader::ResponsePtr response)
+{
+    const juce::ScopedLock sl (cabinetLock);
+    cabinetResponse = std::move (response);
+    cabinetWanted = cabinetResponse != nullptr;
+
+    if (prepared)
+        submitCabinet();
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::submitCabinet()
+{
+    // one for another rate stays out until the processor has it loaded again for this one
+    if (cabinetResponse == nullptr || cabinetResponse->sampleRate != cabinetRate)
+        return;
+
+    cabinetPendingLength = cabinetResponse->buffer.getNumSamples();
+
+    // already trimmed and at the processing rate, so the convolution keeps the length as it is.
+    // It takes the buffer over, and the shared response stays as it is for the other engines
+    cabinet.loadImpulseResponse (juce::AudioBuffer<float> (cabinetResponse->buffer), cabinetRate, juce::dsp::Convolution::Stereo::yes,
+                                 juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::yes);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::processCabinet (juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    // with nothing loaded yet the block passes through, but the convolution still has to run to pick
+    // up the new response. One that was already playing carries on until the new one replaces it
+    auto pending = cabinetPendingLength.load();
+    convolve (block, cabinetLength > 0);
+    acceptCabinet (pending);
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::acceptCabinet (int pending) noexcept
+{
+    // a load started since the pending length was read leaves its own length behind
+    if (pending > 0 && cabinet.getCurrentIRSize() == pending)
+    {
+        cabinetLength = pending;
+        cabinetPendingLength.compare_exchange_strong (pending, 0);
+    }
+}
+
+template <typename SampleType>
+bool DistortionEngine<SampleType>::updateCabinet() noexcept
+{
+    if (! cabinetWanted || ! cabinetSupported)
+        return true;
+
+    if (cabinetPendingLength == 0)
+        return cabinetLength > 0;
+
+    // a single silent sample is enough for the convolution to swap in a finished response
+    auto silence = juce::dsp::AudioBlock<float> (cabinetBuffer).getSubBlock (0, 1);
+    silence.clear();
+
+    auto pending = cabinetPendingLength.load();
+    cabinet.process (juce::dsp::ProcessContextReplacing<float> (silence));
+    acceptCabinet (pending);
+
+    return cabinetLength > 0 && cabinetPendingLength == 0;
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::convolve (juce::dsp::AudioBlock<float>& block, bool replaceBlock) noexcept
+{
+    if (replaceBlock)
+    {
+        cabinet.process (juce::dsp::ProcessContextReplacing<float> (block));
+        return;
+    }
+
+    auto copy = juce::dsp::AudioBlock<float> (cabinetBuffer).getSubsetChannelBlock (0, block.getNumChannels())
+                                                            .getSubBlock (0, block.getNumSamples());
+    copy.copyFrom (block);
+    cabinet.process (juce::dsp::ProcessContextReplacing<float> (copy));
+}
+
+template <typename SampleType>
+void DistortionEngine<SampleType>::convolve (juce::dsp::AudioBlock<double>& block, bool replaceBlock) noexcept
+{
+    auto numSamples = (int) block.getNumSamples();
+    auto floatBlock = juce::dsp::AudioBlock<float> (cabinetBuffer).getSubBlock (0, (size_t) numSamples);
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* source = block.getChannelPointer (channel);
+        auto* dest = floatBlock.getChannelPointer (channel);
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = (float) source[i];
+    }
+
+    cabinet.process (juce::dsp::ProcessContextReplacing<float> (floatBlock));
+
+    if (! replaceBlock)
+        return;
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* source = floatBlock.getChannelPointer (channel);
+        auto* dest = block.getChannelPointer (channel);
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = (double) source[i];
+    }
+}
+
+//==============================================================================
+template class DistortionEngine<float>;
+template class DistortionEngine<double>;
@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    DistortionEngine.h
+
+    The input gain, shaper, filter and dry/wet chain. It's templated on the
+    sample type so the float and double processBlock overloads share one
+    implementation. Parameters come in as a snapshot per block, including
+    the filter settings, which it turns into coefficients itself.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DistortionKernels.h"
+#include "ShaperTables.h"
+#include "SIMDBiquad.h"
+#include "ADAAShaper.h"
+#include "Bitcrusher.h"
+#include "Compressor.h"
+#include "BandSplitter.h"
+#include "ProcessingStats.h"
+#include "ImpulseResponseLoader.h"
+
+//==============================================================================
+/** Everything the engine needs from treeState, read once at the top of each block. */
+struct DistortionParameters
+{
+    float inputGain = 1.0f, drive = 1.0f, outputGain = 1.0f, mix = 1.0f;
+    float cutoff = 20000.0f, lowcut = 20.0f;
+    bool cubicTable = false, stateVariableFilters = false;
+    float resonance = 1.0f;
+    int filterSections = 1;     // per biquad filter, 12 dB/oct each
+    int shaper = ShaperAlgorithms::arctan, quality = 0, oversampler = -1, antialiasing = 0;
+    float crushBits = 24.0f, downsampling = 1.0f;
+    bool dither = false, crushBeforeShaper = false;
+    CompressorSettings compressor;
+    bool compressBeforeShaper = true;
+
+    // the cabinet impulse response, after the filters and before the mix
+    bool cabinet = false;
+
+    /** One band of the multiband mode, the drive goes on top of the main drive. */
+    struct BandSettings
+    {
+        float drive = 1.0f, level = 1.0f;
+        int shaper = ShaperAlgorithms::arctan;
+    };
+
+    // 1 band runs the single shaper, 2 to 4 split at the lowest numBands - 1 crossovers
+    int numBands = 1;
+    std::array<float, 3> crossovers {{ 200.0f, 1000.0f, 5000.0f }};
+    std::array<BandSettings, 4> bands;
+
+    /** How much the chain can raise a quiet signal before the shaper: the input gain and drive,
+        the hottest band's drive and the compressor's makeup when it comes first. The shapers'
+        slope at zero is at most 1, so nothing quiet comes out louder than this.
+    */
+    float getSmallSignalGain() const noexcept
+    {
+        auto gain = inputGain * drive;
+
+        if (numBands > 1)
+        {
+            auto hottest = 0.0f;
+
+            for (int band = 0; band < numBands; ++band)
+                hottest = juce::jmax (hottest, bands[(size_t) band].drive);
+
+            gain *= hottest;
+        }
+
+        if (compressor.isActive() && compressBeforeShaper)
+            gain *= juce::Decibels::decibelsToGain (compressor.makeupDecibels);
+
+        return gain;
+    }
+};
+
+/** Raw biquad coefficients, worked out without the ref-counted Coefficients objects. */
+struct FilterCoefficients
+{
+    BiquadCascade lowPass, highPass;
+
+    /** Butterworth cascades of 1 to 4 sections (12 to 48 dB/oct). The resonance is the Q a single
+        section would have, the last section of a cascade gets the same emphasis over its Butterworth Q.
+        Never allocates, so it's safe on the audio thread.
+    */
+    static FilterCoefficients make (double sampleRate, float cutoff, float lowcut, int numSections, float resonance) noexcept;
+};
+
+//==============================================================================
+template <typename SampleType>
+class DistortionEngine
+{
+public:
+    // every factor (2x to 16x) for both filter types is built in prepare so switching never allocates
+    static constexpr int maxOversamplingFactor = 4;
+    static constexpr int maxOversamplingLatency = 1024;
+
+    DistortionEngine();
+
+    void prepare (const juce::dsp::ProcessSpec& spec, const DistortionParameters& params);
+    void reset() noexcept;
+
+    /** Resets and moves every ramp straight to the given settings, for an engine that's about
+        to be faded in on a preset change. Safe on the audio thread.
+    */
+    void jumpTo (const DistortionParameters& params) noexcept;
+
+    /** Hands the cabinet stage a response from the loader. It's normalised and partitioned on the
+        convolution's background thread, and the audio thread picks it up without waiting. Until it's
+        in place the previous response keeps playing, or the stage passes the signal through. One for
+        another rate waits for a prepare at that rate, nullptr unloads the cabinet.
+        Any thread but the audio thread.
+    */
+    void setCabinet (ImpulseResponseLoader::ResponsePtr response);
+
+    /** The length of the impulse response the audio thread is using, 0 if there isn't one. Audio thread only. */
+    int getCabinetLength() const noexcept     { return cabinetLength; }
+
+    /** For offline rendering, from the thread that processes, between blocks. Swaps in a response
+        that has finished loading without processing any audio, and returns true once the requested
+        response is the one in use, or when there's none to wait for.
+    */
+    bool updateCabinet() noexcept;
+
+    /** Runs the whole chain over the block in place. */
+    void process (juce::dsp::AudioBlock<SampleType> block, const DistortionParameters& params) noexcept;
+
+    /** The latency of the oversampler in use, the dry path is already delayed to match. */
+    int getLatencySamples() const noexcept     { return latency; }
+
+    /** The compressor's deepest gain reduction in the last block, 0 when it's off. */
+    float getGainReductionDecibels() const noexcept     { return compressorActive ? compressor.getGainReductionDecibels() : 0.0f; }
+
+    /** How long each stage of the last process call took. */
+    const ProcessingStats::BlockTiming& getLastTiming() const noexcept     { return lastTiming; }
+
+private:
+    void setOversampler (int index) noexcept;
+    void setWetLatency (int antialiasing) noexcept;
+    void processShaper (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+    void processBands (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+    void shapeBlock (juce::dsp::AudioBlock<SampleType>& block, int shaperType, const DistortionParameters& params,
+                     ADAAShaper<SampleType>& antialiasedShaper) noexcept;
+    void shapeValues (SampleType* data, int numValues, int shaperType, const DistortionParameters& params) noexcept;
+    void processBitcrusher (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+    void processCompressor (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+    void processFilters (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+    void processBiquads (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+    void retuneBiquads (const DistortionParameters& params) noexcept;
+    void processStateVariableFilters (juce::dsp::AudioBlock<SampleType>& block, const DistortionParameters& params) noexcept;
+
+    void processCabinet (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+    void submitCabinet();   // with cabinetLock held
+    void acceptCabinet (int pending) noexcept;
+
+    // the convolution only takes float, so the double engine converts around it. When the result
+    // isn't wanted it runs on a copy, which still swaps in a response that has finished loading
+    void convolve (juce::dsp::AudioBlock<float>& block, bool replaceBlock) noexcept;
+    void convolve (juce::dsp::AudioBlock<double>& block, bool replaceBlock) noexcept;
+
+    // biquad cascades for the selectable slopes, with the channels packed into SIMD lanes so a
+    // 48 dB/oct stereo filter costs four sections rather than eight
+    SIMDBiquad<SampleType> lowPassLanes, highPassLanes;
+
+    // the biquads follow the same cutoff ramps as the state variable filters, retuned every
+    // biquadRetuneInterval samples while one moves. Otherwise they're only worked out again when a
+    // setting differs from what they were tuned to, a tunedSections of 0 forces it
+    static constexpr size_t biquadRetuneInterval = 32;
+    SampleType tunedCutoff = 0, tunedLowcut = 0;
+    float tunedResonance = 0;
+    int tunedSections = 0;
+
+    // the alternative filter mode, its cutoff can move every sample without rebuilding anything.
+    // It stays at 12 dB/oct whatever the slope
+    juce::dsp::StateVariableTPTFilter<SampleType> stateVariableLowPass, stateVariableHighPass;
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> cutoffFrequency, lowcutFrequency;
+    bool stateVariableFiltersActive = false;
+
+    // holds the dry copy of each block, sized in prepare so process never allocates
+    juce::dsp::DryWetMixer<SampleType> dryWetMixer { maxOversamplingLatency };
+
+    juce::OwnedArray<juce::dsp::Oversampling<SampleType>> oversamplers;
+    int currentOversampler = -1, latency = 0;
+
+    // the antialiased shaper, used instead of the kernels and tables when ADAA is on. Its
+    // fractional delay isn't reported to the host, the dry path is delayed to match it instead
+    ADAAShaper<SampleType> adaaShaper;
+    SampleType wetLatency = -1;
+
+    // the multiband mode splits inside the oversampled block, so the crossovers are set at that rate.
+    // Each band has its own ADAA history, and they all add the same delay as the single shaper
+    BandSplitter<SampleType> bandSplitter;
+    ADAAShaper<SampleType> bandShapers[BandSplitter<SampleType>::maxBands];
+    int activeBands = 1;
+    double sampleRate = 44100.0;
+
+    ProcessingStats::BlockTiming lastTiming;
+
+    // zero latency, the head of the response is convolved directly and the rest in growing partitions.
+    // Every instance in the process shares one background thread for loading responses
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> convolutionQueue;
+    juce::dsp::Convolution cabinet { juce::dsp::Convolution::NonUniform { 256 }, *convolutionQueue };
+    bool cabinetSupported = false;
+    juce::AudioBuffer<float> cabinetBuffer;
+
+    // the response as it came from the loader, kept so prepare can load it again. The lock keeps
+    // setCabinet and prepare apart, the audio thread never takes it
+    juce::CriticalSection cabinetLock;
+    ImpulseResponseLoader::ResponsePtr cabinetResponse;
+    double cabinetRate = 0;
+    bool prepared = false;
+    std::atomic<bool> cabinetWanted { false };
+
+    // the convolution swaps a new response in on the audio thread and says nothing, so the stage only
+    // counts as loaded once the active response has the length the requested one was resampled to
+    std::atomic<int> cabinetPendingLength { 0 };
+    int cabinetLength = 0;
+
+    // runs at the host rate either side of the shaper, skipped entirely when it would do nothing
+    Bitcrusher<SampleType> bitcrusher;
+
+    // before the input gain or after the shaper, skipped at 1:1
+    Compressor<SampleType> compressor;
+    bool compressorActive = false;
+
+    // per-sample ramps so automation doesn't zipper, the mix is ramped inside dryWetMixer
+    juce::SmoothedValue<SampleType> inputGain, driveGain, outputGain;
+
+    // the combined input * drive ramp, worked out once per block and applied to every channel
+    juce::HeapBlock<SampleType> gainRamp;
+
+    // SSE / NEON / scalar shapers, picked once for this CPU
+    const DistortionKernels::Kernels<SampleType>& shaperKernels;
+
+    // lookup tables for the table quality settings, shared read-only by every instance in the process
+    juce::SharedResourcePointer<ShaperTables> shaperTables;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionEngine)
+};
@@ -0,0 +1,470 @@
+/*
+  ==============================================================================
+
+    DistortionKernels.cpp
+
+  ==============================================================================
+*/
+
+#include "DistortionKernels.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+namespace DistortionKernels
+{
+    // coefficients of the atan polynomial in ShaperAlgorithms::fastAtan, highest order first
+    static constexpr double atanCoeffs[] = { -0.01172120, 0.05265332, -0.11643287,
+                                              0.19354346, -0.33262347, 0.99997726 };
+
+    static constexpr double outputScale = 2.0 / juce::MathConstants<double>::pi;
+
+    // the rectifier is the arctan curve with the sign thrown away, so it shares the arctan kernels
+    template <typename Algorithm>
+    static constexpr bool isRectifier() noexcept     { return std::is_same<Algorithm, ShaperAlgorithms::Rectifier>::value; }
+
+    //==============================================================================
+   #if JUCE_USE_SSE_INTRINSICS
+    template <typename Algorithm>
+    static void arctanSSE (float* data, int numSamples, float drive) noexcept
+    {
+        const auto vDrive  = _mm_set1_ps (drive);
+        const auto one     = _mm_set1_ps (1.0f);
+        const auto halfPi  = _mm_set1_ps (juce::MathConstants<float>::halfPi);
+        const auto scale   = _mm_set1_ps ((float) outputScale);
+        const auto signBit = _mm_set1_ps (-0.0f);
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto x = _mm_mul_ps (_mm_loadu_ps (data + i), vDrive);
+            auto sign = _mm_and_ps (x, signBit);
+            auto a = _mm_andnot_ps (signBit, x);
+
+            auto t = _mm_div_ps (_mm_min_ps (a, one), _mm_max_ps (a, one));
+            auto t2 = _mm_mul_ps (t, t);
+
+            auto p = _mm_set1_ps ((float) atanCoeffs[0]);
+
+            for (int c = 1; c < 6; ++c)
+                p = _mm_add_ps (_mm_mul_ps (p, t2), _mm_set1_ps ((float) atanCoeffs[c]));
+
+            p = _mm_mul_ps (p, t);
+
+            // atan (x) = pi/2 - atan (1/x) for x > 1, then put the sign back
+            auto isLarge = _mm_cmpgt_ps (a, one);
+            p = _mm_or_ps (_mm_and_ps (isLarge, _mm_sub_ps (halfPi, p)), _mm_andnot_ps (isLarge, p));
+
+            if (! isRectifier<Algorithm>())
+                p = _mm_or_ps (p, sign);
+
+            _mm_storeu_ps (data + i, _mm_mul_ps (p, scale));
+        }
+
+        shapeScalar<Algorithm> (data + i, numSamples - i, drive);
+    }
+
+    static void hardclipSSE (float* data, int numSamples, float drive) noexcept
+    {
+        const auto vDrive = _mm_set1_ps (drive);
+        const auto upper  = _mm_set1_ps (1.0f);
+        const auto lower  = _mm_set1_ps (-1.0f);
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto x = _mm_mul_ps (_mm_loadu_ps (data + i), vDrive);
+            _mm_storeu_ps (data + i, _mm_min_ps (_mm_max_ps (x, lower), upper));
+        }
+
+        shapeScalar<ShaperAlgorithms::HardClip> (data + i, numSamples - i, drive);
+    }
+
+    // steps every lane's xorshift32 generator
+    static inline __m128i nextRandomSSE (__m128i& seeds) noexcept
+    {
+        seeds = _mm_xor_si128 (seeds, _mm_slli_epi32 (seeds, 13));
+        seeds = _mm_xor_si128 (seeds, _mm_srli_epi32 (seeds, 17));
+        seeds = _mm_xor_si128 (seeds, _mm_slli_epi32 (seeds, 5));
+        return seeds;
+    }
+
+    // the top 23 bits as the mantissa of a float in [1, 2), minus 1
+    static inline __m128 toUniformSSE (__m128i bits) noexcept
+    {
+        auto oneToTwo = _mm_or_si128 (_mm_srli_epi32 (bits, 9), _mm_set1_epi32 (0x3f800000));
+        return _mm_sub_ps (_mm_castsi128_ps (oneToTwo), _mm_set1_ps (1.0f));
+    }
+
+    static void quantiseSSE (float* data, int numSamples, float levels, float dither, DitherState& state) noexcept
+    {
+        const auto vLevels  = _mm_set1_ps (levels);
+        const auto vInverse = _mm_set1_ps (1.0f / levels);
+        const auto vDither  = _mm_set1_ps (dither);
+        const auto signBit  = _mm_set1_ps (-0.0f);
+        const auto half     = _mm_set1_ps (0.5f);
+        const auto one      = _mm_set1_ps (1.0f);
+
+        // past 2^23 a float is already a whole number, and the int conversion would overflow further up
+        const auto exact    = _mm_set1_ps (8388608.0f);
+
+        auto seeds = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (state.seeds));
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto noise = _mm_sub_ps (toUniformSSE (nextRandomSSE (seeds)), toUniformSSE (nextRandomSSE (seeds)));
+            auto x = _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (data + i), vLevels), _mm_mul_ps (vDither, noise));
+
+            // round half away from zero like std::round in quantiseScalar, rather than to even under
+            // the default MXCSR: truncate, then step away from zero where the part cut off was a half or more
+            auto truncated = _mm_cvtepi32_ps (_mm_cvttps_epi32 (x));
+            auto roundAway = _mm_cmpge_ps (_mm_andnot_ps (signBit, _mm_sub_ps (x, truncated)), half);
+            auto rounded = _mm_add_ps (truncated, _mm_and_ps (roundAway, _mm_or_ps (_mm_and_ps (signBit, x), one)));
+            auto inRange = _mm_cmplt_ps (_mm_andnot_ps (signBit, x), exact);
+            x = _mm_or_ps (_mm_and_ps (inRange, rounded), _mm_andnot_ps (inRange, x));
+
+            _mm_storeu_ps (data + i, _mm_mul_ps (x, vInverse));
+        }
+
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (state.seeds), seeds);
+        quantiseScalar (data + i, numSamples - i, levels, dither, state);
+    }
+
+    static void measureSSE (const float* data, int numSamples, float& peak, float& sumOfSquares) noexcept
+    {
+        const auto signBit = _mm_set1_ps (-0.0f);
+
+        auto peaks = _mm_setzero_ps();
+        auto sums = _mm_setzero_ps();
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto x = _mm_loadu_ps (data + i);
+            peaks = _mm_max_ps (peaks, _mm_andnot_ps (signBit, x));
+            sums = _mm_add_ps (sums, _mm_mul_ps (x, x));
+        }
+
+        float peakLanes[4], sumLanes[4];
+        _mm_storeu_ps (peakLanes, peaks);
+        _mm_storeu_ps (sumLanes, sums);
+
+        measureScalar (data + i, numSamples - i, peak, sumOfSquares);
+
+        peak = juce::jmax (peak, juce::jmax (juce::jmax (peakLanes[0], peakLanes[1]), juce::jmax (peakLanes[2], peakLanes[3])));
+        sumOfSquares += (sumLanes[0] + sumLanes[1]) + (sumLanes[2] + sumLanes[3]);
+    }
+
+    // the same kernels, two doubles per register
+    template <typename Algorithm>
+    static void arctanSSE (double* data, int numSamples, double drive) noexcept
+    {
+        const auto vDrive  = _mm_set1_pd (drive);
+        const auto one     = _mm_set1_pd (1.0);
+        const auto halfPi  = _mm_set1_pd (juce::MathConstants<double>::halfPi);
+        const auto scale   = _mm_set1_pd (outputScale);
+        const auto signBit = _mm_set1_pd (-0.0);
+
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            auto x = _mm_mul_pd (_mm_loadu_pd (data + i), vDrive);
+            auto sign = _mm_and_pd (x, signBit);
+            auto a = _mm_andnot_pd (signBit, x);
+
+            auto t = _mm_div_pd (_mm_min_pd (a, one), _mm_max_pd (a, one));
+            auto t2 = _mm_mul_pd (t, t);
+
+            auto p = _mm_set1_pd (atanCoeffs[0]);
+
+            for (int c = 1; c < 6; ++c)
+                p = _mm_add_pd (_mm_mul_pd (p, t2), _mm_set1_pd (atanCoeffs[c]));
+
+            p = _mm_mul_pd (p, t);
+
+            auto isLarge = _mm_cmpgt_pd (a, one);
+            p = _mm_or_pd (_mm_and_pd (isLarge, _mm_sub_pd (halfPi, p)), _mm_andnot_pd (isLarge, p));
+
+            if (! isRectifier<Algorithm>())
+                p = _mm_or_pd (p, sign);
+
+            _mm_storeu_pd (data + i, _mm_mul_pd (p, scale));
+        }
+
+        shapeScalar<Algorithm> (data + i, numSamples - i, drive);
+    }
+
+    static void hardclipSSE (double* data, int numSamples, double drive) noexcept
+    {
+        const auto vDrive = _mm_set1_pd (drive);
+        const auto upper  = _mm_set1_pd (1.0);
+        const auto lower  = _mm_set1_pd (-1.0);
+
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            auto x = _mm_mul_pd (_mm_loadu_pd (data + i), vDrive);
+            _mm_storeu_pd (data + i, _mm_min_pd (_mm_max_pd (x, lower), upper));
+        }
+
+        shapeScalar<ShaperAlgorithms::HardClip> (data + i, numSamples - i, drive);
+    }
+
+    static void quantiseSSE (double* data, int numSamples, double levels, double dither, DitherState& state) noexcept
+    {
+        const auto vLevels  = _mm_set1_pd (levels);
+        const auto vInverse = _mm_set1_pd (1.0 / levels);
+        const auto vDither  = _mm_set1_pd (dither);
+        const auto signBit  = _mm_set1_pd (-0.0);
+        const auto half     = _mm_set1_pd (0.5);
+        const auto one      = _mm_set1_pd (1.0);
+
+        // the conversion only goes through int32, anything bigger is left unrounded,
+        // which at that size moves it by less than one part in 2^31
+        const auto exact    = _mm_set1_pd (2147483520.0);
+
+        auto seeds = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (state.seeds));
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            // four uniforms per step, two for each lane's triangular noise
+            auto uniforms = toUniformSSE (nextRandomSSE (seeds));
+            auto noise = _mm_sub_pd (_mm_cvtps_pd (uniforms), _mm_cvtps_pd (_mm_movehl_ps (uniforms, uniforms)));
+            auto x = _mm_add_pd (_mm_mul_pd (_mm_loadu_pd (data + i), vLevels), _mm_mul_pd (vDither, noise));
+
+            // half away from zero, the same as the float version
+            auto truncated = _mm_cvtepi32_pd (_mm_cvttpd_epi32 (x));
+            auto roundAway = _mm_cmpge_pd (_mm_andnot_pd (signBit, _mm_sub_pd (x, truncated)), half);
+            auto rounded = _mm_add_pd (truncated, _mm_and_pd (roundAway, _mm_or_pd (_mm_and_pd (signBit, x), one)));
+            auto inRange = _mm_cmplt_pd (_mm_andnot_pd (signBit, x), exact);
+            x = _mm_or_pd (_mm_and_pd (inRange, rounded), _mm_andnot_pd (inRange, x));
+
+            _mm_storeu_pd (data + i, _mm_mul_pd (x, vInverse));
+        }
+
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (state.seeds), seeds);
+        quantiseScalar (data + i, numSamples - i, levels, dither, state);
+    }
+
+    static void measureSSE (const double* data, int numSamples, double& peak, double& sumOfSquares) noexcept
+    {
+        const auto signBit = _mm_set1_pd (-0.0);
+
+        auto peaks = _mm_setzero_pd();
+        auto sums = _mm_setzero_pd();
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            auto x = _mm_loadu_pd (data + i);
+            peaks = _mm_max_pd (peaks, _mm_andnot_pd (signBit, x));
+            sums = _mm_add_pd (sums, _mm_mul_pd (x, x));
+        }
+
+        double peakLanes[2], sumLanes[2];
+        _mm_storeu_pd (peakLanes, peaks);
+        _mm_storeu_pd (sumLanes, sums);
+
+        measureScalar (data + i, numSamples - i, peak, sumOfSquares);
+
+        peak = juce::jmax (peak, juce::jmax (peakLanes[0], peakLanes[1]));
+        sumOfSquares += sumLanes[0] + sumLanes[1];
+    }
+   #endif
+
+    //==============================================================================
+   #if JUCE_USE_ARM_NEON
+    template <typename Algorithm>
+    static void arctanNeon (float* data, int numSamples, float drive) noexcept
+    {
+        const auto one     = vdupq_n_f32 (1.0f);
+        const auto halfPi  = vdupq_n_f32 (juce::MathConstants<float>::halfPi);
+        const auto signBit = vdupq_n_u32 (0x80000000u);
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto x = vmulq_n_f32 (vld1q_f32 (data + i), drive);
+            auto a = vabsq_f32 (x);
+
+            auto num = vminq_f32 (a, one);
+            auto den = vmaxq_f32 (a, one);
+
+           #if defined (__aarch64__)
+            auto t = vdivq_f32 (num, den);
+           #else
+            // two Newton-Raphson steps on the reciprocal estimate get us to float precision
+            auto r = vrecpeq_f32 (den);
+            r = vmulq_f32 (vrecpsq_f32 (den, r), r);
+            r = vmulq_f32 (vrecpsq_f32 (den, r), r);
+            auto t = vmulq_f32 (num, r);
+           #endif
+
+            auto t2 = vmulq_f32 (t, t);
+            auto p = vdupq_n_f32 ((float) atanCoeffs[0]);
+
+            for (int c = 1; c < 6; ++c)
+                p = vmlaq_f32 (vdupq_n_f32 ((float) atanCoeffs[c]), p, t2);
+
+            p = vmulq_f32 (p, t);
+            p = vbslq_f32 (vcgtq_f32 (a, one), vsubq_f32 (halfPi, p), p);
+
+            if (! isRectifier<Algorithm>())
+                p = vbslq_f32 (signBit, x, p);
+
+            vst1q_f32 (data + i, vmulq_n_f32 (p, (float) outputScale));
+        }
+
+        shapeScalar<Algorithm> (data + i, numSamples - i, drive);
+    }
+
+    static void hardclipNeon (float* data, int numSamples, float drive) noexcept
+    {
+        const auto upper = vdupq_n_f32 (1.0f);
+        const auto lower = vdupq_n_f32 (-1.0f);
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto x = vmulq_n_f32 (vld1q_f32 (data + i), drive);
+            vst1q_f32 (data + i, vminq_f32 (vmaxq_f32 (x, lower), upper));
+        }
+
+        shapeScalar<ShaperAlgorithms::HardClip> (data + i, numSamples - i, drive);
+    }
+
+    static void quantiseNeon (float* data, int numSamples, float levels, float dither, DitherState& state) noexcept
+    {
+        const auto half     = vdupq_n_f32 (0.5f);
+        const auto exact    = vdupq_n_f32 (8388608.0f);
+        const auto signBit  = vdupq_n_u32 (0x80000000u);
+        const auto oneBits  = vdupq_n_u32 (0x3f800000u);
+        const auto one      = vdupq_n_f32 (1.0f);
+
+        auto seeds = vld1q_u32 (state.seeds);
+
+        auto nextUniform = [&]
+        {
+            seeds = veorq_u32 (seeds, vshlq_n_u32 (seeds, 13));
+            seeds = veorq_u32 (seeds, vshrq_n_u32 (seeds, 17));
+            seeds = veorq_u32 (seeds, vshlq_n_u32 (seeds, 5));
+            return vsubq_f32 (vreinterpretq_f32_u32 (vorrq_u32 (vshrq_n_u32 (seeds, 9), oneBits)), one);
+        };
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto noise = vsubq_f32 (nextUniform(), nextUniform());
+            auto x = vmlaq_n_f32 (vmulq_n_f32 (vld1q_f32 (data + i), levels), noise, dither);
+
+            // vcvtq truncates, so step away from zero where the part cut off was a half or more. Adding
+            // a signed half before truncating would round 0.49999997 up, which std::round doesn't
+            auto truncated = vcvtq_f32_s32 (vcvtq_s32_f32 (x));
+            auto roundAway = vcgeq_f32 (vabsq_f32 (vsubq_f32 (x, truncated)), half);
+            auto step = vreinterpretq_f32_u32 (vandq_u32 (roundAway, vbslq_u32 (signBit, vreinterpretq_u32_f32 (x), oneBits)));
+            auto rounded = vaddq_f32 (truncated, step);
+            x = vbslq_f32 (vcltq_f32 (vabsq_f32 (x), exact), rounded, x);
+
+            vst1q_f32 (data + i, vmulq_n_f32 (x, 1.0f / levels));
+        }
+
+        vst1q_u32 (state.seeds, seeds);
+        quantiseScalar (data + i, numSamples - i, levels, dither, state);
+    }
+
+    static void measureNeon (const float* data, int numSamples, float& peak, float& sumOfSquares) noexcept
+    {
+        auto peaks = vdupq_n_f32 (0.0f);
+        auto sums = vdupq_n_f32 (0.0f);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto x = vld1q_f32 (data + i);
+            peaks = vmaxq_f32 (peaks, vabsq_f32 (x));
+            sums = vmlaq_f32 (sums, x, x);
+        }
+
+        float peakLanes[4], sumLanes[4];
+        vst1q_f32 (peakLanes, peaks);
+        vst1q_f32 (sumLanes, sums);
+
+        measureScalar (data + i, numSamples - i, peak, sumOfSquares);
+
+        peak = juce::jmax (peak, juce::jmax (juce::jmax (peakLanes[0], peakLanes[1]), juce::jmax (peakLanes[2], peakLanes[3])));
+        sumOfSquares += (sumLanes[0] + sumLanes[1]) + (sumLanes[2] + sumLanes[3]);
+    }
+   #endif
+
+    //==============================================================================
+    template <>
+    const Kernels<float>& getKernels<float>() noexcept
+    {
+        // anything without a vector version keeps its generated scalar kernel
+        static const Kernels<float> best = []
+        {
+            auto kernels = getScalarKernels<float>();
+
+           #if JUCE_USE_SSE_INTRINSICS
+            if (juce::SystemStats::hasSSE2())
+            {
+                kernels.shapers[ShaperAlgorithms::arctan] = arctanSSE<ShaperAlgorithms::Arctan>;
+                kernels.shapers[ShaperAlgorithms::hardclip] = hardclipSSE;
+                kernels.shapers[ShaperAlgorithms::rectifier] = arctanSSE<ShaperAlgorithms::Rectifier>;
+                kernels.quantise = quantiseSSE;
+                kernels.measure = measureSSE;
+                kernels.name = "sse2";
+            }
+           #elif JUCE_USE_ARM_NEON
+            kernels.shapers[ShaperAlgorithms::arctan] = arctanNeon<ShaperAlgorithms::Arctan>;
+            kernels.shapers[ShaperAlgorithms::hardclip] = hardclipNeon;
+            kernels.shapers[ShaperAlgorithms::rectifier] = arctanNeon<ShaperAlgorithms::Rectifier>;
+            kernels.quantise = quantiseNeon;
+            kernels.measure = measureNeon;
+            kernels.name = "neon";
+           #endif
+
+            return kernels;
+        }();
+
+        return best;
+    }
+
+    template <>
+    const Kernels<double>& getKernels<double>() noexcept
+    {
+        // NEON only has double lanes on aarch64, so ARM builds use the scalar doubles
+        static const Kernels<double> best = []
+        {
+            auto kernels = getScalarKernels<double>();
+
+           #if JUCE_USE_SSE_INTRINSICS
+            if (juce::SystemStats::hasSSE2())
+            {
+                kernels.shapers[ShaperAlgorithms::arctan] = arctanSSE<ShaperAlgorithms::Arctan>;
+                kernels.shapers[ShaperAlgorithms::hardclip] = hardclipSSE;
+                kernels.shapers[ShaperAlgorithms::rectifier] = arctanSSE<ShaperAlgorithms::Rectifier>;
+                kernels.quantise = quantiseSSE;
+                kernels.measure = measureSSE;
+                kernels.name = "sse2";
+            }
+           #endif
+
+            return kernels;
+        }();
+
+        return best;
+    }
+}
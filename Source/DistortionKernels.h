@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    DistortionKernels.h
+
+    Block based waveshaper kernels for the distortion stage. Each kernel
+    processes a whole channel in place. Every algorithm in ShaperAlgorithms
+    gets a generated scalar kernel, and the common ones have SSE / NEON
+    versions picked at runtime. The metering reduction lives here too.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ShaperAlgorithms.h"
+
+namespace DistortionKernels
+{
+    /** Noise for the quantiser's dither, four xorshift32 generators so the vector
+        versions can run one per lane. The scalar version only uses the first.
+    */
+    struct DitherState
+    {
+        juce::uint32 seeds[4] { 0x9e3779b9u, 0x7f4a7c15u, 0x85ebca6bu, 0xc2b2ae35u };
+
+        /** Gives each channel its own noise. */
+        void seed (juce::uint32 channel) noexcept
+        {
+            for (auto& s : seeds)
+                s ^= (channel + 1) * 0x2545f491u;
+        }
+
+        /** Uniform in [0, 1). */
+        float nextUniform() noexcept
+        {
+            auto& s = seeds[0];
+            s ^= s << 13;
+            s ^= s >> 17;
+            s ^= s << 5;
+            return (float) (s >> 8) * (1.0f / 16777216.0f);
+        }
+    };
+
+    /** The set of kernels available on this machine for one sample type. */
+    template <typename SampleType>
+    struct Kernels
+    {
+        /** Processes numSamples of data in place, drive is applied before the curve. */
+        using ShaperFunction = void (*) (SampleType* data, int numSamples, SampleType drive);
+
+        /** Rounds numSamples of data in place to multiples of 1 / levels, adding dither
+            (0 for none, 1 for +-1 step of triangular noise) before rounding.
+        */
+        using QuantiseFunction = void (*) (SampleType* data, int numSamples, SampleType levels,
+                                           SampleType dither, DitherState& state);
+
+        /** The largest magnitude and the sum of squares of numSamples of data, in one pass. */
+        using MeasureFunction = void (*) (const SampleType* data, int numSamples, SampleType& peak, SampleType& sumOfSquares);
+
+        // indexed by ShaperAlgorithms::Type, so picking a shaper is one lookup per block
+        ShaperFunction shapers[ShaperAlgorithms::numTypes];
+        QuantiseFunction quantise;
+        MeasureFunction measure;
+        const char* name;
+    };
+
+    /** The generated kernel for one algorithm, also used for the tail of a block that
+        doesn't fill a whole register in the vector versions.
+    */
+    template <typename Algorithm, typename SampleType>
+    void shapeScalar (SampleType* data, int numSamples, SampleType drive) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = Algorithm::process (data[i] * drive);
+    }
+
+    template <typename SampleType>
+    void quantiseScalar (SampleType* data, int numSamples, SampleType levels, SampleType dither, DitherState& state) noexcept
+    {
+        const auto inverse = SampleType (1) / levels;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // the difference of two uniforms is triangular over [-1, 1]
+            auto noise = (SampleType) (state.nextUniform() - state.nextUniform());
+            data[i] = std::round (data[i] * levels + dither * noise) * inverse;
+        }
+    }
+
+    template <typename SampleType>
+    void measureScalar (const SampleType* data, int numSamples, SampleType& peak, SampleType& sumOfSquares) noexcept
+    {
+        // four independent accumulators, so the adds don't wait on each other
+        SampleType peaks[4] {}, sums[4] {};
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                peaks[j] = juce::jmax (peaks[j], std::abs (data[i + j]));
+                sums[j] += data[i + j] * data[i + j];
+            }
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            peaks[0] = juce::jmax (peaks[0], std::abs (data[i]));
+            sums[0] += data[i] * data[i];
+        }
+
+        peak = juce::jmax (juce::jmax (peaks[0], peaks[1]), juce::jmax (peaks[2], peaks[3]));
+        sumOfSquares = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    }
+
+    template <typename SampleType, typename... Algorithms>
+    Kernels<SampleType> makeScalarKernels (ShaperAlgorithms::List<Algorithms...>) noexcept
+    {
+        return { { shapeScalar<Algorithms, SampleType>... }, quantiseScalar<SampleType>, measureScalar<SampleType>, "scalar" };
+    }
+
+    /** Returns the fastest kernels the current CPU supports. The choice is made
+        once on the first call, so call this from prepareToPlay or the constructor
+        rather than the audio thread.
+    */
+    template <typename SampleType>
+    const Kernels<SampleType>& getKernels() noexcept;
+
+    template <> const Kernels<float>& getKernels<float>() noexcept;
+    template <> const Kernels<double>& getKernels<double>() noexcept;
+
+    /** Always returns the scalar kernels, handy for comparing against the vector paths. */
+    template <typename SampleType>
+    const Kernels<SampleType>& getScalarKernels() noexcept
+    {
+        static const Kernels<SampleType> scalar = makeScalarKernels<SampleType> (ShaperAlgorithms::All());
+        return scalar;
+    }
+}
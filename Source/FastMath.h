@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Cheap log2 / exp2 for the per-sample level and gain work, so the dynamics
+    and metering code never calls std::log or std::pow on the audio thread.
+    Both split the float into exponent and mantissa and fit a polynomial to
+    the mantissa part.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace FastMath
+{
+    /** log2 (x) for x > 0, absolute error below 1.7e-5 (1e-4 dB). Zero and denormals
+        come out around -127, which is far enough below anything audible to act as silence.
+    */
+    inline float fastLog2 (float x) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+
+        auto exponent = (float) ((int) ((bits >> 23) & 0xff) - 127);
+
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+        float m;
+        std::memcpy (&m, &bits, sizeof (m));
+
+        // 5th order fit to log2 over the mantissa's [1, 2)
+        auto p = 0.0430049578f;
+        p = p * m - 0.402513394f;
+        p = p * m + 1.58947429f;
+        p = p * m - 3.48987855f;
+        p = p * m + 5.04785541f;
+        p = p * m - 2.78792621f;
+
+        return exponent + p;
+    }
+
+    /** 2^x, relative error below 3.5e-6 (3e-5 dB), clamped to the normal float range. */
+    inline float fastExp2 (float x) noexcept
+    {
+        x = juce::jlimit (-126.0f, 126.0f, x);
+
+        auto whole = std::floor (x);
+        auto f = x - whole;
+
+        // 4th order fit to 2^f over [0, 1)
+        auto p = 0.0136703095f;
+        p = p * f + 0.0517449978f;
+        p = p * f + 0.241604357f;
+        p = p * f + 0.692972922f;
+        p = p * f + 1.00000349f;
+
+        auto bits = (juce::uint32) ((int) whole + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+
+        return scale * p;
+    }
+
+    /** Decibels to and from the log2 domain the dynamics work in. */
+    constexpr float decibelsPerLog2 = 6.0205999f;
+}
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    ImpulseResponseLoader.cpp
+
+  ==============================================================================
+*/
+
+#include "ImpulseResponseLoader.h"
+
+namespace
+{
+    // leading and trailing silence, below -80 dB, only costs convolution time
+    juce::AudioBuffer<float> trimImpulseResponse (const juce::AudioBuffer<float>& source)
+    {
+        const auto threshold = juce::Decibels::decibelsToGain (-80.0f);
+        auto first = source.getNumSamples(), last = -1;
+
+        for (int channel = 0; channel < source.getNumChannels(); ++channel)
+        {
+            auto* data = source.getReadPointer (channel);
+
+            for (int i = 0; i < source.getNumSamples(); ++i)
+            {
+                if (std::abs (data[i]) > threshold)
+                {
+                    first = juce::jmin (first, i);
+                    last = juce::jmax (last, i);
+                }
+            }
+        }
+
+        if (last < first)
+            return {};
+
+        juce::AudioBuffer<float> trimmed (source.getNumChannels(), last - first + 1);
+
+        for (int channel = 0; channel < source.getNumChannels(); ++channel)
+            trimmed.copyFrom (channel, 0, source, channel, first, trimmed.getNumSamples());
+
+        return trimmed;
+    }
+
+    // done here rather than by the convolution, so the length it ends up with is known exactly
+    juce::AudioBuffer<float> resampleImpulseResponse (juce::AudioBuffer<float> source, double sourceRate, double destRate)
+    {
+        if (sourceRate == destRate)
+            return source;
+
+        auto ratio = sourceRate / destRate;
+        auto length = juce::jmax (1, juce::roundToInt (source.getNumSamples() / ratio));
+
+        juce::MemoryAudioSource memorySource (source, false);
+        juce::ResamplingAudioSource resampler (&memorySource, false, source.getNumChannels());
+        resampler.setResamplingRatio (ratio);
+        resampler.prepareToPlay (length, destRate);
+
+        juce::AudioBuffer<float> resampled (source.getNumChannels(), length);
+        resampler.getNextAudioBlock (juce::AudioSourceChannelInfo (resampled));
+
+        return resampled;
+    }
+}
+
+//==============================================================================
+ImpulseResponseLoader::ImpulseResponseLoader()
+    : juce::Thread ("Impulse response loader")
+{
+    startThread();
+}
+
+ImpulseResponseLoader::~ImpulseResponseLoader()
+{
+    // every owner has cancelled by now, so nothing is left that would need its callback
+    stopThread (-1);
+}
+
+void ImpulseResponseLoader::load (const void* owner, const juce::File& file, double sampleRate, Callback callback)
+{
+    {
+        const juce::ScopedLock sl (queueLock);
+
+        queue.erase (std::remove_if (queue.begin(), queue.end(), [owner] (const Request& r) { return r.owner == owner; }),
+                     queue.end());
+        queue.push_back ({ owner, file, sampleRate, std::move (callback) });
+    }
+
+    notify();
+}
+
+void ImpulseResponseLoader::cancel (const void* owner)
+{
+    {
+        const juce::ScopedLock sl (queueLock);
+
+        queue.erase (std::remove_if (queue.begin(), queue.end(), [owner] (const Request& r) { return r.owner == owner; }),
+                     queue.end());
+    }
+
+    // a request is taken off the queue with this held, so once it's free the owner's is done too
+    const juce::ScopedLock waitForRunning (runningLock);
+}
+
+void ImpulseResponseLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        {
+            const juce::ScopedLock running (runningLock);
+            std::unique_ptr<Request> request;
+
+            {
+                const juce::ScopedLock sl (queueLock);
+
+                if (! queue.empty())
+                {
+                    request = std::make_unique<Request> (std::move (queue.front()));
+                    queue.erase (queue.begin());
+                }
+            }
+
+            if (request != nullptr)
+            {
+                request->callback (read (request->file, request->sampleRate));
+                continue;
+            }
+        }
+
+        // a load while this thread was busy has already signalled it, so this returns straight away
+        wait (-1);
+    }
+}
+
+ImpulseResponseLoader::ResponsePtr ImpulseResponseLoader::read (const juce::File& file, double sampleRate)
+{
+    if (! file.existsAsFile() || sampleRate <= 0)
+        return {};
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader { formatManager.createReaderFor (file) };
+
+    if (reader == nullptr)
+        return {};
+
+    // the convolution only does mono or stereo, and nothing longer than 10 s is a cabinet
+    auto length = (int) juce::jmin (reader->lengthInSamples, (juce::int64) (reader->sampleRate * 10.0));
+    juce::AudioBuffer<float> impulseResponse ((int) juce::jmin (2u, reader->numChannels), length);
+    reader->read (&impulseResponse, 0, length, 0, true, true);
+
+    auto trimmed = trimImpulseResponse (impulseResponse);
+
+    if (trimmed.getNumSamples() == 0 || reader->sampleRate <= 0)
+        return {};
+
+    auto response = std::make_shared<Response>();
+    response->buffer = resampleImpulseResponse (std::move (trimmed), reader->sampleRate, sampleRate);
+    response->sampleRate = sampleRate;
+    return response;
+}
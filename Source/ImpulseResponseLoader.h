@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    ImpulseResponseLoader.h
+
+    Reads cabinet impulse responses away from the message and audio
+    threads. Every instance in the process shares one background thread.
+    A request reads the file, trims the silence either side and resamples
+    it once to the processing rate. The finished response goes to a
+    callback on that thread, and it never changes after that, so every
+    engine can share the one copy.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ImpulseResponseLoader : private juce::Thread
+{
+public:
+    /** A trimmed response at the rate it's played at. */
+    struct Response
+    {
+        juce::AudioBuffer<float> buffer;
+        double sampleRate = 0;
+    };
+
+    using ResponsePtr = std::shared_ptr<const Response>;
+    using Callback = std::function<void (ResponsePtr)>;
+
+    ImpulseResponseLoader();
+    ~ImpulseResponseLoader() override;
+
+    /** Queues the file to be read and resampled to sampleRate, replacing anything the same owner
+        queued that hasn't started yet. The callback runs on the loader's thread, with nullptr if the
+        file can't be read or holds nothing above the trim threshold.
+    */
+    void load (const void* owner, const juce::File& file, double sampleRate, Callback callback);
+
+    /** Drops the owner's queued request and waits for one that's running, so none of its
+        callbacks are called once this returns.
+    */
+    void cancel (const void* owner);
+
+private:
+    void run() override;
+
+    static ResponsePtr read (const juce::File& file, double sampleRate);
+
+    struct Request
+    {
+        const void* owner;
+        juce::File file;
+        double sampleRate;
+        Callback callback;
+    };
+
+    // the queue lock is only held to add or take a request, the running one holds the other
+    // for as long as it takes, so cancel can wait for it
+    juce::CriticalSection queueLock, runningLock;
+    std::vector<Request> queue;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ImpulseResponseLoader)
+};
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+
+    Peak and RMS of one point in the chain. The audio thread folds each
+    block into two atomics, the peak and one 64-bit word holding the sum of
+    squares together with the number of samples it covers, and the editor
+    takes whatever has built up since its last read. Nothing waits on anything: the writer's
+    compare-exchange loops only repeat if the reader swapped the value in
+    between, and the reader never loops at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DistortionKernels.h"
+
+class LevelMeter
+{
+public:
+    /** What built up since the last read, as linear gains. */
+    struct Reading
+    {
+        float peak = 0, rms = 0;
+    };
+
+    LevelMeter() = default;
+
+    /** Audio thread. Every channel of the block goes into the one reading. */
+    template <typename SampleType>
+    void measure (const juce::dsp::AudioBlock<SampleType>& block, const DistortionKernels::Kernels<SampleType>& kernels) noexcept
+    {
+        auto numSamples = (int) block.getNumSamples();
+
+        if (numSamples == 0)
+            return;
+
+        SampleType blockPeak = 0, blockSum = 0;
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            SampleType peak, sum;
+            kernels.measure (block.getChannelPointer (channel), numSamples, peak, sum);
+
+            blockPeak = juce::jmax (blockPeak, peak);
+            blockSum += sum;
+        }
+
+        // the RMS is of the channels' mean square, so a mono signal reads the same on any layout
+        auto meanSquare = (float) (blockSum / (SampleType) block.getNumChannels());
+
+        storeMax (peak, (float) blockPeak);
+
+        auto current = energy.load();
+
+        while (! energy.compare_exchange_weak (current, pack ({ unpack (current).sumOfSquares + meanSquare,
+                                                                unpack (current).numSamples + (float) numSamples })))
+        {
+        }
+    }
+
+    /** Reader thread. Returns the peak and RMS since the last read and starts them over. */
+    Reading read() noexcept
+    {
+        Reading reading;
+        reading.peak = peak.exchange (0);
+
+        // one exchange, so the sum always comes with its own count
+        auto total = unpack (energy.exchange (0));
+        reading.rms = total.numSamples > 0 ? std::sqrt (total.sumOfSquares / total.numSamples) : 0.0f;
+
+        return reading;
+    }
+
+    /** Raises value to newValue if it's lower, without a lock. */
+    static void storeMax (std::atomic<float>& value, float newValue) noexcept
+    {
+        auto current = value.load();
+
+        while (current < newValue && ! value.compare_exchange_weak (current, newValue))
+        {
+        }
+    }
+
+private:
+    struct Energy
+    {
+        float sumOfSquares, numSamples;
+    };
+
+    static_assert (sizeof (Energy) == sizeof (juce::uint64), "the sum and count have to fit one atomic word");
+
+    static juce::uint64 pack (Energy value) noexcept
+    {
+        juce::uint64 bits;
+        std::memcpy (&bits, &value, sizeof (bits));
+        return bits;
+    }
+
+    static Energy unpack (juce::uint64 bits) noexcept
+    {
+        Energy value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+
+    // all zero bits is a sum of 0 over 0 samples
+    std::atomic<float> peak { 0 };
+    std::atomic<juce::uint64> energy { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    LevelMeterComponent.cpp
+
+  ==============================================================================
+*/
+
+#include "LevelMeterComponent.h"
+
+namespace
+{
+    // peaks and gain reduction fall back at this rate, the RMS is smoothed over this time
+    constexpr double fallbackDecibelsPerSecond = 20.0;
+    constexpr double rmsSeconds = 0.3;
+
+    constexpr float labelWidth = 32.0f;
+
+    // only repaint for a change that moves the bar
+    constexpr float repaintThreshold = 0.1f;
+}
+
+//==============================================================================
+LevelMeterComponent::LevelMeterComponent (const juce::String& labelText)
+    : label (labelText)
+{
+    setOpaque (true);
+}
+
+void LevelMeterComponent::update (const LevelMeter::Reading& reading, double elapsedSeconds)
+{
+    auto newPeak = juce::jmax (juce::Decibels::gainToDecibels (reading.peak, minimumDecibels),
+                               peakDecibels - (float) (fallbackDecibelsPerSecond * elapsedSeconds));
+
+    rms += (float) (1.0 - std::exp (-elapsedSeconds / rmsSeconds)) * (reading.rms - rms);
+    auto newRms = juce::Decibels::gainToDecibels (rms, minimumDecibels);
+
+    newPeak = juce::jlimit (minimumDecibels, maximumDecibels, newPeak);
+    newRms = juce::jlimit (minimumDecibels, maximumDecibels, newRms);
+
+    if (std::abs (newPeak - peakDecibels) < repaintThreshold && std::abs (newRms - rmsDecibels) < repaintThreshold)
+        return;
+
+    peakDecibels = newPeak;
+    rmsDecibels = newRms;
+    repaint();
+}
+
+void LevelMeterComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    g.fillAll (juce::Colours::black);
+
+    g.setColour (juce::Colours::white);
+    g.setFont (12.0f);
+    g.drawText (label, bounds.removeFromLeft (labelWidth), juce::Justification::centredLeft, false);
+
+    g.setColour (juce::Colour (0xff202020));
+    g.fillRect (bounds);
+
+    auto toX = [&bounds] (float decibels)
+    {
+        return bounds.getX() + bounds.getWidth() * juce::jmap (decibels, minimumDecibels, maximumDecibels, 0.0f, 1.0f);
+    };
+
+    // 0 dBFS is marked, anything past it shows in red
+    auto zero = toX (0.0f);
+
+    g.setColour (juce::Colours::darkred);
+    g.fillRect (bounds.withRight (toX (juce::jmin (rmsDecibels, 0.0f))));
+
+    if (rmsDecibels > 0.0f)
+    {
+        g.setColour (juce::Colours::red);
+        g.fillRect (bounds.withLeft (zero).withRight (toX (rmsDecibels)));
+    }
+
+    g.setColour (peakDecibels > 0.0f ? juce::Colours::red : juce::Colours::white);
+    g.fillRect (juce::Rectangle<float> (toX (peakDecibels) - 1.0f, bounds.getY(), 2.0f, bounds.getHeight()));
+
+    g.setColour (juce::Colours::grey);
+    g.drawVerticalLine (juce::roundToInt (zero), bounds.getY(), bounds.getBottom());
+}
+
+//==============================================================================
+void GainReductionMeterComponent::update (float reductionDecibels, double elapsedSeconds)
+{
+    auto newDecibels = juce::jlimit (0.0f, maximumDecibels,
+                                     juce::jmax (reductionDecibels, decibels - (float) (fallbackDecibelsPerSecond * elapsedSeconds)));
+
+    if (std::abs (newDecibels - decibels) < repaintThreshold)
+        return;
+
+    decibels = newDecibels;
+    repaint();
+}
+
+void GainReductionMeterComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    g.fillAll (juce::Colours::black);
+
+    g.setColour (juce::Colours::white);
+    g.setFont (12.0f);
+    g.drawText ("GR", bounds.removeFromLeft (labelWidth), juce::Justification::centredLeft, false);
+
+    g.setColour (juce::Colour (0xff202020));
+    g.fillRect (bounds);
+
+    g.setColour (juce::Colours::orange);
+    g.fillRect (bounds.withLeft (bounds.getRight() - bounds.getWidth() * decibels / maximumDecibels));
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    LevelMeterComponent.h
+
+    Horizontal bar meters for the editor. They don't read anything
+    themselves, the editor's timer hands them each reading along with how
+    long it's been since the last one, and they only repaint when the bar
+    has moved.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+//==============================================================================
+/** Peak and RMS on one bar, the RMS solid and the peak as a line that falls back slowly. */
+class LevelMeterComponent  : public juce::Component
+{
+public:
+    static constexpr float minimumDecibels = -60.0f, maximumDecibels = 6.0f;
+
+    explicit LevelMeterComponent (const juce::String& labelText);
+
+    void update (const LevelMeter::Reading& reading, double elapsedSeconds);
+
+    void paint (juce::Graphics&) override;
+
+private:
+    juce::String label;
+    float peakDecibels = minimumDecibels, rmsDecibels = minimumDecibels;
+    float rms = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterComponent)
+};
+
+//==============================================================================
+/** The compressor's gain reduction, growing from the right. */
+class GainReductionMeterComponent  : public juce::Component
+{
+public:
+    static constexpr float maximumDecibels = 24.0f;
+
+    GainReductionMeterComponent() = default;
+
+    void update (float reductionDecibels, double elapsedSeconds);
+
+    void paint (juce::Graphics&) override;
+
+private:
+    float decibels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainReductionMeterComponent)
+};
@@ -14,7 +14,11 @@ VenomDistortionAudioProcessorEditor::VenomDistortionAudioProcessorEditor (VenomD
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
     
-    setSize (700, 300);
+    setOpaque (true);
+    setResizable (true, true);
+    setResizeLimits (designWidth / 2, designHeight / 2, designWidth * 2, designHeight * 2);
+    getConstrainer()->setFixedAspectRatio ((double) designWidth / (double) designHeight);
+    setSize (designWidth, designHeight);
      
     // OUTPUT
     // these define the parameters of our slider object
@@ -114,48 +118,239 @@ VenomDistortionAudioProcessorEditor::VenomDistortionAudioProcessorEditor (VenomD
     
     highPassValue = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, LOWCUT_ID, highPassSlider);
     
-    //arctan button
-    //arctanButton.onClick = [this]() {};
-    //addAndMakeVisible (&arctanButton);
+    // arctan, hardclip and rectifier buttons, a radio group driving the type parameter
+    typeValue = std::make_unique<juce::ParameterAttachment>(*audioProcessor.prmType, [this] (float value) { updateTypeButtons ((int) value); });
     
-    // hardclip button
-    hardclipButton.setColour(juce::TextButton::buttonColourId, juce::Colours::black);
-    hardclipButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::darkred);
-    hardclipButton.setClickingTogglesState (true);
-    hardclipButton.onClick = [this]() {}; //juce::AudioProcessorValueTreeState::Listener::parameterChanged(TYPE_ID,1);
-    addAndMakeVisible (&hardclipButton);
+    for (int type = 0; type < ShaperAlgorithms::numTypes; ++type)
+    {
+        auto* button = typeButtons[type];
+        button->setColour(juce::TextButton::buttonColourId, juce::Colours::black);
+        button->setColour(juce::TextButton::buttonOnColourId, juce::Colours::darkred);
+        button->setRadioGroupId (1);
+        button->onClick = [this, type]() { typeValue->setValueAsCompleteGesture ((float) type); };
+        addAndMakeVisible (button);
+    }
+    
+    typeValue->sendInitialUpdate();
+    
+    presetBox.setTextWhenNothingSelected ("Presets");
+    presetBox.onChange = [this]()
+    {
+        auto index = presetBox.getSelectedId() - 1;
+        
+        if (index >= 0 && index != audioProcessor.getCurrentProgram())
+            audioProcessor.setCurrentProgram (index);
+    };
+    addAndMakeVisible (presetBox);
+    refreshPresetList();
+    
+    savePresetButton.setColour(juce::TextButton::buttonColourId, juce::Colours::black);
+    savePresetButton.onClick = [this]() { showSavePresetWindow(); };
+    addAndMakeVisible (savePresetButton);
+    
+    cabinetButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::red);
+    addAndMakeVisible (cabinetButton);
+    cabinetValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, CABINET_ID, cabinetButton);
+    
+    loadIRButton.setColour(juce::TextButton::buttonColourId, juce::Colours::black);
+    loadIRButton.onClick = [this]() { chooseImpulseResponse(); };
+    addAndMakeVisible (loadIRButton);
+    updateIRButton();
+    
+    cpuLabel.setFont (juce::Font (13.0f));
+    cpuLabel.setColour (juce::Label::textColourId, juce::Colours::grey);
+    cpuLabel.setJustificationType (juce::Justification::centredRight);
+    addAndMakeVisible (cpuLabel);
+    
+    addAndMakeVisible (inputMeter);
+    addAndMakeVisible (outputMeter);
+    addAndMakeVisible (gainReductionMeter);
     
-    hardclipValue = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, "hardclip", hardclipButton);
+    // the audio thread only measures while this editor is open
+    audioProcessor.setMeteringEnabled (true);
+    lastMeterTime = juce::Time::getMillisecondCounterHiRes();
     
+    spectrumDisplay = std::make_unique<SpectrumDisplay> (audioProcessor.getSpectrumAnalyser(),
+                                                         *audioProcessor.treeState.getRawParameterValue (CUTOFF_ID),
+                                                         *audioProcessor.treeState.getRawParameterValue (LOWCUT_ID));
+    addAndMakeVisible (*spectrumDisplay);
+    
+    audioProcessor.getPresetLibrary().addChangeListener (this);
+    
+    startTimerHz (30);
+    resized();
 }
 
 VenomDistortionAudioProcessorEditor::~VenomDistortionAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.getPresetLibrary().removeChangeListener (this);
+    audioProcessor.setMeteringEnabled (false);
+    spectrumDisplay.reset();
+}
+
+void VenomDistortionAudioProcessorEditor::timerCallback()
+{
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    auto elapsed = (now - lastMeterTime) * 0.001;
+    lastMeterTime = now;
+    
+    inputMeter.update (audioProcessor.getInputMeter().read(), elapsed);
+    outputMeter.update (audioProcessor.getOutputMeter().read(), elapsed);
+    gainReductionMeter.update (audioProcessor.readGainReduction(), elapsed);
+    
+    if (--ticksUntilCpuUpdate <= 0)
+    {
+        ticksUntilCpuUpdate = 8;
+        updateCpuLabel();
+        
+        // the host can change the program
+        if (presetBox.getNumItems() != audioProcessor.getNumPrograms())
+            refreshPresetList();
+        else if (presetBox.getSelectedId() != audioProcessor.getCurrentProgram() + 1)
+            presetBox.setSelectedId (audioProcessor.getCurrentProgram() + 1, juce::dontSendNotification);
+        
+        // a preset or the host can change the impulse response too
+        updateIRButton();
+    }
+}
+
+void VenomDistortionAudioProcessorEditor::updateCpuLabel()
+{
+    auto stats = audioProcessor.getProcessingStats().getSummary();
+    
+    cpuLabel.setText ("CPU " + juce::String (stats.currentLoad * 100.0, 1) + "%", juce::dontSendNotification);
+    
+    // the per-stage breakdown is there on hover
+    juce::String breakdown ("peak " + juce::String (stats.peakLoad * 100.0, 1) + "%, ns/sample:");
+    
+    for (int stage = 0; stage < ProcessingStats::numStages; ++stage)
+        breakdown << " " << ProcessingStats::getStageName (stage) << " " << juce::String (stats.stageNanosPerSample[stage], 1);
+    
+    cpuLabel.setTooltip (breakdown);
+}
+
+void VenomDistortionAudioProcessorEditor::refreshPresetList()
+{
+    auto& library = audioProcessor.getPresetLibrary();
+    auto numFactory = library.getNumFactoryPresets();
+    
+    presetBox.clear (juce::dontSendNotification);
+    
+    for (int i = 0; i < library.getNumPresets(); ++i)
+    {
+        if (i == numFactory)
+            presetBox.addSeparator();
+        
+        presetBox.addItem (library.getName (i), i + 1);
+    }
+    
+    presetBox.setSelectedId (audioProcessor.getCurrentProgram() + 1, juce::dontSendNotification);
+}
+
+void VenomDistortionAudioProcessorEditor::changeListenerCallback (juce::ChangeBroadcaster*)
+{
+    refreshPresetList();
+}
+
+void VenomDistortionAudioProcessorEditor::showSavePresetWindow()
+{
+    auto* window = new juce::AlertWindow ("Save Preset", "Save the current settings as a user preset.", juce::AlertWindow::NoIcon, this);
+    window->addTextEditor ("name", audioProcessor.getPresetLibrary().isUserPreset (audioProcessor.getCurrentProgram()) ? presetBox.getText() : juce::String());
+    window->addButton ("Save", 1, juce::KeyPress (juce::KeyPress::returnKey));
+    window->addButton ("Cancel", 0, juce::KeyPress (juce::KeyPress::escapeKey));
+    
+    juce::Component::SafePointer<VenomDistortionAudioProcessorEditor> safeThis (this);
+    
+    // the window deletes itself after the callback
+    window->enterModalState (true, juce::ModalCallbackFunction::create ([safeThis, window] (int result)
+    {
+        auto name = window->getTextEditorContents ("name").trim();
+        
+        if (result == 1 && name.isNotEmpty() && safeThis != nullptr)
+        {
+            safeThis->audioProcessor.saveUserPreset (name);
+            safeThis->refreshPresetList();
+        }
+    }), true);
+}
+
+void VenomDistortionAudioProcessorEditor::chooseImpulseResponse()
+{
+    auto current = audioProcessor.getCabinetImpulseResponse();
+    irChooser = std::make_unique<juce::FileChooser> ("Choose an impulse response", current.existsAsFile() ? current : juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+    
+    irChooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles, [this] (const juce::FileChooser& chooser)
+    {
+        auto file = chooser.getResult();
+        
+        if (file.existsAsFile())
+        {
+            audioProcessor.setCabinetImpulseResponse (file);
+            updateIRButton();
+        }
+    });
+}
+
+void VenomDistortionAudioProcessorEditor::updateIRButton()
+{
+    auto file = audioProcessor.getCabinetImpulseResponse();
+    auto text = file.existsAsFile() ? file.getFileNameWithoutExtension() : juce::String ("Load IR");
     
+    if (loadIRButton.getButtonText() != text)
+    {
+        loadIRButton.setButtonText (text);
+        loadIRButton.setTooltip (file.getFullPathName());
+    }
+}
+
+void VenomDistortionAudioProcessorEditor::updateTypeButtons (int type)
+{
+    for (int i = 0; i < ShaperAlgorithms::numTypes; ++i)
+        typeButtons[i]->setToggleState (i == type, juce::dontSendNotification);
 }
 
 //==============================================================================
 void VenomDistortionAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    // a repaint of anything but the editor itself only asks for the area behind it, so this is
+    // usually a small clipped blit
+    auto pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
     
+    if (background.isNull() || pixelScale != backgroundScale)
+        renderBackground (pixelScale);
+    
+    g.drawImage (background, getLocalBounds().toFloat());
+}
+
+void VenomDistortionAudioProcessorEditor::renderBackground (float pixelScale)
+{
+    backgroundScale = pixelScale;
+    background = juce::Image (juce::Image::RGB,
+                              juce::jmax (1, juce::roundToInt ((float) getWidth() * pixelScale)),
+                              juce::jmax (1, juce::roundToInt ((float) getHeight() * pixelScale)),
+                              false);
+    
+    juce::Graphics g (background);
+    g.addTransform (juce::AffineTransform::scale (pixelScale));
     
-    // fill the whole window white
     g.fillAll (juce::Colours::black);
-     
-    // set the current drawing colour to black
+    
     g.setColour (juce::Colours::white);
-     
-    // set the font size and draw text to the screen
-    g.setFont (20.0f);
-     
-    g.drawFittedText ("Venom Distortion", 0, 30, getWidth(), 30, juce::Justification::centred, 1);
-    
-    g.drawFittedText ("Input", -267, 110, getWidth(), 30, juce::Justification::centred, 1);
-    g.drawFittedText ("Drive", -157, 110, getWidth(), 30, juce::Justification::centred, 1);
-    g.drawFittedText ("Low Cut", -50, 110, getWidth(), 30, juce::Justification::centred, 1);
-    g.drawFittedText ("High Cut", 65, 110, getWidth(), 30, juce::Justification::centred, 1);
-    g.drawFittedText ("Output", 173, 110, getWidth(), 30, juce::Justification::centred, 1);
-    g.drawFittedText ("Mix", 282, 110, getWidth(), 30, juce::Justification::centred, 1);
+    g.setFont (20.0f * layoutScale);
+    
+    g.drawFittedText ("Venom Distortion", 0, juce::roundToInt (30 * layoutScale), getWidth(), juce::roundToInt (30 * layoutScale), juce::Justification::centred, 1);
+    
+    // each label sits centred just above its knob
+    std::pair<juce::Slider*, const char*> labels[] { { &inputSlider, "Input" }, { &driveSlider, "Drive" }, { &highPassSlider, "Low Cut" },
+                                                     { &cutoffSlider, "High Cut" }, { &outputSlider, "Output" }, { &mixSlider, "Mix" } };
+    
+    for (auto& label : labels)
+    {
+        auto bounds = label.first->getBounds();
+        g.drawFittedText (label.second, bounds.getX(), bounds.getY() - juce::roundToInt (25 * layoutScale),
+                          bounds.getWidth(), juce::roundToInt (30 * layoutScale), juce::Justification::centred, 1);
+    }
 }
 
 void VenomDistortionAudioProcessorEditor::resized()
@@ -164,17 +359,42 @@ void VenomDistortionAudioProcessorEditor::resized()
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
     
-    // sets the position and size of the slider with arguments (x, y, width, height)
-    //outputVolume.setBounds (40, 30, 20, getHeight() - 60);
+    // everything is placed in design coordinates, (x, y, width, height), and scaled to the window
+    layoutScale = (float) getWidth() / (float) designWidth;
+    
+    auto place = [this] (juce::Component& component, int x, int y, int width, int height)
+    {
+        component.setBounds (juce::Rectangle<int> (x, y, width, height).toFloat().transformedBy (juce::AffineTransform::scale (layoutScale)).getSmallestIntegerContainer());
+    };
+    
+    place(inputSlider, 30, 135, 110, 115);
+    place(driveSlider, 140, 135, 110, 115);
+    place(highPassSlider, 250, 135, 110, 115);
+    place(cutoffSlider, 360, 135, 110, 115);
+    place(outputSlider, 470, 135, 110, 115);
+    place(mixSlider, 580, 135, 110, 115);
+    
+    place(arctanButton, 20, 25, 70, 40);
+    place(hardclipButton, 95, 25, 70, 40);
+    place(rectifierButton, 170, 25, 70, 40);
+    
+    place(presetBox, 250, 75, 150, 24);
+    place(savePresetButton, 405, 75, 55, 24);
+    
+    place(loadIRButton, designWidth - 230, 85, 160, 20);
+    place(cabinetButton, designWidth - 65, 85, 55, 20);
+    
+    place(cpuLabel, designWidth - 130, 10, 120, 20);
+    
+    place(inputMeter, designWidth - 230, 35, 220, 12);
+    place(outputMeter, designWidth - 230, 51, 220, 12);
+    place(gainReductionMeter, designWidth - 230, 67, 220, 12);
     
-    inputSlider.setBounds(30, getHeight()/4+60, 110, 115);
-    driveSlider.setBounds(140, getHeight()/4+60, 110, 115);
-    highPassSlider.setBounds(250, getHeight()/4+60, 110, 115);
-    cutoffSlider.setBounds(360, getHeight()/4+60, 110, 115);
-    outputSlider.setBounds(470, getHeight()/4+60, 110, 115);
-    mixSlider.setBounds(580, getHeight()/4+60, 110, 115);
+    if (spectrumDisplay != nullptr)
+        place(*spectrumDisplay, 20, 290, designWidth - 40, designHeight - 300);
     
-    hardclipButton.setBounds(60, 25, 80, 60);
+    // the labels follow the knobs, so they're redrawn on the next paint
+    background = juce::Image();
 }
 
 void VenomDistortionAudioProcessorEditor::sliderValueChanged (juce::Slider* slider)
@@ -10,12 +10,16 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "LevelMeterComponent.h"
+#include "SpectrumDisplay.h"
 
 //==============================================================================
 /**
 */
 class VenomDistortionAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                             public juce::Slider::Listener
+                                             public juce::Slider::Listener,
+                                             private juce::ChangeListener,
+                                             private juce::Timer
 {
 public:
     VenomDistortionAudioProcessorEditor (VenomDistortionAudioProcessor&);
@@ -41,6 +45,55 @@ private:
     juce::TextButton hardclipButton {"Crush"};
     juce::TextButton rectifierButton {"Rectifier"};
     
+    // one button per shaper type, in ShaperAlgorithms::Type order
+    juce::TextButton* typeButtons[ShaperAlgorithms::numTypes] { &arctanButton, &hardclipButton, &rectifierButton };
+    
+    void updateTypeButtons (int type);
+    
+    // the host's program list, factory presets first. The timer keeps it in step with the host,
+    // and the shared library says when any instance has saved or renamed a user preset
+    juce::ComboBox presetBox;
+    juce::TextButton savePresetButton {"Save"};
+    
+    void refreshPresetList();
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+    void showSavePresetWindow();
+    
+    // the cabinet switch, and a button that picks the impulse response and shows its name
+    juce::ToggleButton cabinetButton {"Cab"};
+    juce::TextButton loadIRButton;
+    std::unique_ptr<juce::FileChooser> irChooser;
+    
+    void chooseImpulseResponse();
+    void updateIRButton();
+    
+    // the processing load readout, refreshed a few times a second
+    juce::Label cpuLabel;
+    juce::TooltipWindow tooltipWindow { this };
+    
+    // the meters take a reading every timer tick, the CPU readout every few
+    LevelMeterComponent inputMeter { "IN" }, outputMeter { "OUT" };
+    GainReductionMeterComponent gainReductionMeter;
+    double lastMeterTime = 0;
+    int ticksUntilCpuUpdate = 0;
+    
+    void timerCallback() override;
+    void updateCpuLabel();
+    
+    // runs the processor's analyser for as long as it exists
+    std::unique_ptr<SpectrumDisplay> spectrumDisplay;
+    
+    // the layout is designed at this size and scaled to whatever the window is
+    static constexpr int designWidth = 700, designHeight = 420;
+    float layoutScale = 1.0f;
+    
+    // the title and knob labels never change, so they're drawn once into an image at the
+    // display's pixel scale and just blitted after that, until the size or scale changes
+    juce::Image background;
+    float backgroundScale = 0;
+    
+    void renderBackground (float pixelScale);
+    
 //    juce::AudioProcessorValueTreeState::SliderAttachment drive;
 //    juce::AudioProcessorValueTreeState::SliderAttachment mix;
 //    juce::AudioProcessorValueTreeState::SliderAttachment output;
@@ -58,7 +111,8 @@ public:
     std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> cutoffValue;
     std::unique_ptr <juce::AudioProcessorValueTreeState::SliderAttachment> highPassValue;
     
-    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> hardclipValue;
+    std::unique_ptr <juce::ParameterAttachment> typeValue;
+    std::unique_ptr <juce::AudioProcessorValueTreeState::ButtonAttachment> cabinetValue;
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VenomDistortionAudioProcessorEditor)
@@ -7,7 +7,10 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+
+#if ! VENOM_HEADLESS
+ #include "PluginEditor.h"
+#endif
 
 //==============================================================================
 VenomDistortionAudioProcessor::VenomDistortionAudioProcessor()
@@ -20,9 +23,7 @@ VenomDistortionAudioProcessor::VenomDistortionAudioProcessor()
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        ),
-treeState (*this, nullptr, "PARAMETER", createParameterLayout()),
-lowPassFilter(juce::dsp::IIR::Coefficients<float>::makeLowPass(44100, 20000, 0.7)),
-highPassFilter(juce::dsp::IIR::Coefficients<float>::makeHighPass(44100, 20, 0.7))
+treeState (*this, nullptr, "PARAMETER", createParameterLayout())
 #endif
 {
 //    juce::NormalisableRange<float> cutoffRange (20.0f, 20000.0f);
@@ -31,10 +32,64 @@ highPassFilter(juce::dsp::IIR::Coefficients<float>::makeHighPass(44100, 20, 0.7)
 //
 //    treeState.createAndAddParameter(LOWCUT_ID, LOWCUT_NAME, LOWCUT_ID, cutoffRange, 20.0f, nullptr, nullptr);
     
+    inputParam = treeState.getRawParameterValue (INPUT_ID);
+    driveParam = treeState.getRawParameterValue (DRIVE_ID);
+    outputParam = treeState.getRawParameterValue (OUTPUT_ID);
+    mixParam = treeState.getRawParameterValue (MIX_ID);
+    cutoffParam = treeState.getRawParameterValue (CUTOFF_ID);
+    lowcutParam = treeState.getRawParameterValue (LOWCUT_ID);
+    typeParam = treeState.getRawParameterValue (TYPE_ID);
+    prmType = dynamic_cast<juce::AudioParameterChoice*> (treeState.getParameter (TYPE_ID));
+    qualityParam = treeState.getRawParameterValue (QUALITY_ID);
+    cubicParam = treeState.getRawParameterValue (CUBIC_ID);
+    oversamplingParam = treeState.getRawParameterValue (OVERSAMPLING_ID);
+    osFilterParam = treeState.getRawParameterValue (OSFILTER_ID);
+    filterModeParam = treeState.getRawParameterValue (FILTERMODE_ID);
+    antialiasingParam = treeState.getRawParameterValue (ANTIALIASING_ID);
+    bitsParam = treeState.getRawParameterValue (BITS_ID);
+    downsampleParam = treeState.getRawParameterValue (DOWNSAMPLE_ID);
+    ditherParam = treeState.getRawParameterValue (DITHER_ID);
+    crushPositionParam = treeState.getRawParameterValue (CRUSHPOSITION_ID);
+    compThresholdParam = treeState.getRawParameterValue (COMPTHRESHOLD_ID);
+    compRatioParam = treeState.getRawParameterValue (COMPRATIO_ID);
+    compAttackParam = treeState.getRawParameterValue (COMPATTACK_ID);
+    compReleaseParam = treeState.getRawParameterValue (COMPRELEASE_ID);
+    compMakeupParam = treeState.getRawParameterValue (COMPMAKEUP_ID);
+    compDetectorParam = treeState.getRawParameterValue (COMPDETECTOR_ID);
+    compLinkParam = treeState.getRawParameterValue (COMPLINK_ID);
+    compPositionParam = treeState.getRawParameterValue (COMPPOSITION_ID);
+    bandsParam = treeState.getRawParameterValue (BANDS_ID);
+    
+    for (size_t i = 0; i < crossoverParams.size(); ++i)
+        crossoverParams[i] = treeState.getRawParameterValue (CROSSOVER_ID + juce::String ((int) i + 1));
+    
+    for (size_t band = 0; band < bandDriveParams.size(); ++band)
+    {
+        bandDriveParams[band] = treeState.getRawParameterValue (BANDDRIVE_ID + juce::String ((int) band + 1));
+        bandTypeParams[band] = treeState.getRawParameterValue (BANDTYPE_ID + juce::String ((int) band + 1));
+        bandLevelParams[band] = treeState.getRawParameterValue (BANDLEVEL_ID + juce::String ((int) band + 1));
+    }
+    
+    sleepThresholdParam = treeState.getRawParameterValue (SLEEPTHRESHOLD_ID);
+    cabinetParam = treeState.getRawParameterValue (CABINET_ID);
+    slopeParam = treeState.getRawParameterValue (SLOPE_ID);
+    resonanceParam = treeState.getRawParameterValue (RESONANCE_ID);
+    
+    treeState.state.addListener (this);
+    
+    presetLibrary->setFactoryPresets (getParameters(), makeFactoryPresets(), factoryPresetRevision);
+    presetLibrary->addChangeListener (this);
+    
+    startTimerHz (20);
 }
 
 VenomDistortionAudioProcessor::~VenomDistortionAudioProcessor()
 {
+    stopTimer();
+    impulseResponseLoader->cancel (this);
+    
+    treeState.state.removeListener (this);
+    presetLibrary->removeChangeListener (this);
 }
 
 //==============================================================================
@@ -65,8 +120,127 @@ juce::AudioProcessorValueTreeState::ParameterLayout VenomDistortionAudioProcesso
     params.push_back(std::move(lowCutParam));
     
 
-    auto hardclipBoolParam = std::make_unique<juce::AudioParameterBool>("hardclip", "Hardclip", false);
-    params.push_back(std::move(hardclipBoolParam));
+    // one choice per entry in ShaperAlgorithms::All, this replaces the old "hardclip" bool
+    auto typeParam = std::make_unique<juce::AudioParameterChoice>(TYPE_ID, TYPE_NAME, ShaperAlgorithms::getNames(), ShaperAlgorithms::arctan);
+    params.push_back(std::move(typeParam));
+    
+    // "Direct" runs the polynomial kernels, the others read the shared lookup tables
+    auto qualityParam = std::make_unique<juce::AudioParameterChoice>(QUALITY_ID, QUALITY_NAME, juce::StringArray { "Direct", "Table 512", "Table 4096", "Table 65536" }, 0);
+    params.push_back(std::move(qualityParam));
+    
+    auto cubicParam = std::make_unique<juce::AudioParameterBool>(CUBIC_ID, CUBIC_NAME, false);
+    params.push_back(std::move(cubicParam));
+    
+    // only the shaper runs at the oversampled rate, the filters and mix stay at the host rate
+    auto oversamplingParam = std::make_unique<juce::AudioParameterChoice>(OVERSAMPLING_ID, OVERSAMPLING_NAME, juce::StringArray { "Off", "2x", "4x", "8x", "16x" }, 0);
+    params.push_back(std::move(oversamplingParam));
+    
+    auto osFilterParam = std::make_unique<juce::AudioParameterChoice>(OSFILTER_ID, OSFILTER_NAME, juce::StringArray { "Polyphase IIR", "Linear Phase FIR" }, 0);
+    params.push_back(std::move(osFilterParam));
+    
+    // ADAA takes most of the aliasing out without oversampling, it replaces the direct kernels and tables when on
+    auto antialiasingParam = std::make_unique<juce::AudioParameterChoice>(ANTIALIASING_ID, ANTIALIASING_NAME, juce::StringArray { "Off", "ADAA 1st Order", "ADAA 2nd Order" }, 0);
+    params.push_back(std::move(antialiasingParam));
+    
+    // 24 bits and no downsampling leave the crusher switched off
+    auto bitsParam = std::make_unique<juce::AudioParameterFloat>(BITS_ID, BITS_NAME, juce::NormalisableRange<float>(1.0f, 24.0f, 0.01f), 24.0f);
+    params.push_back(std::move(bitsParam));
+    
+    auto downsampleRange = juce::NormalisableRange<float>(1.0f, 50.0f, 0.01f);
+    downsampleRange.setSkewForCentre(8.0f);
+    
+    auto downsampleParam = std::make_unique<juce::AudioParameterFloat>(DOWNSAMPLE_ID, DOWNSAMPLE_NAME, downsampleRange, 1.0f);
+    params.push_back(std::move(downsampleParam));
+    
+    auto ditherParam = std::make_unique<juce::AudioParameterBool>(DITHER_ID, DITHER_NAME, false);
+    params.push_back(std::move(ditherParam));
+    
+    auto crushPositionParam = std::make_unique<juce::AudioParameterChoice>(CRUSHPOSITION_ID, CRUSHPOSITION_NAME, juce::StringArray { "Pre Shaper", "Post Shaper" }, 1);
+    params.push_back(std::move(crushPositionParam));
+    
+    // a ratio of 1:1 switches the compressor off
+    auto compThresholdParam = std::make_unique<juce::AudioParameterFloat>(COMPTHRESHOLD_ID, COMPTHRESHOLD_NAME, -60.0f, 0.0f, 0.0f);
+    params.push_back(std::move(compThresholdParam));
+    
+    auto compRatioRange = juce::NormalisableRange<float>(1.0f, 20.0f, 0.01f);
+    compRatioRange.setSkewForCentre(4.0f);
+    
+    auto compRatioParam = std::make_unique<juce::AudioParameterFloat>(COMPRATIO_ID, COMPRATIO_NAME, compRatioRange, 1.0f);
+    params.push_back(std::move(compRatioParam));
+    
+    auto compAttackRange = juce::NormalisableRange<float>(0.1f, 100.0f, 0.01f);
+    compAttackRange.setSkewForCentre(10.0f);
+    
+    auto compAttackParam = std::make_unique<juce::AudioParameterFloat>(COMPATTACK_ID, COMPATTACK_NAME, compAttackRange, 10.0f);
+    params.push_back(std::move(compAttackParam));
+    
+    auto compReleaseRange = juce::NormalisableRange<float>(5.0f, 1000.0f, 0.1f);
+    compReleaseRange.setSkewForCentre(100.0f);
+    
+    auto compReleaseParam = std::make_unique<juce::AudioParameterFloat>(COMPRELEASE_ID, COMPRELEASE_NAME, compReleaseRange, 100.0f);
+    params.push_back(std::move(compReleaseParam));
+    
+    auto compMakeupParam = std::make_unique<juce::AudioParameterFloat>(COMPMAKEUP_ID, COMPMAKEUP_NAME, 0.0f, 24.0f, 0.0f);
+    params.push_back(std::move(compMakeupParam));
+    
+    auto compDetectorParam = std::make_unique<juce::AudioParameterChoice>(COMPDETECTOR_ID, COMPDETECTOR_NAME, juce::StringArray { "Peak", "RMS" }, 0);
+    params.push_back(std::move(compDetectorParam));
+    
+    auto compLinkParam = std::make_unique<juce::AudioParameterFloat>(COMPLINK_ID, COMPLINK_NAME, 0.0f, 1.0f, 1.0f);
+    params.push_back(std::move(compLinkParam));
+    
+    auto compPositionParam = std::make_unique<juce::AudioParameterChoice>(COMPPOSITION_ID, COMPPOSITION_NAME, juce::StringArray { "Pre Shaper", "Post Shaper" }, 0);
+    params.push_back(std::move(compPositionParam));
+    
+    // "Off" runs the single shaper, the others split at the lowest crossovers and shape each band on its own
+    auto bandsParam = std::make_unique<juce::AudioParameterChoice>(BANDS_ID, BANDS_NAME, juce::StringArray { "Off", "2 Bands", "3 Bands", "4 Bands" }, 0);
+    params.push_back(std::move(bandsParam));
+    
+    const float crossoverDefaults[] = { 200.0f, 1000.0f, 5000.0f };
+    
+    for (int i = 0; i < 3; ++i)
+    {
+        auto crossoverParam = std::make_unique<juce::AudioParameterFloat>(CROSSOVER_ID + juce::String(i + 1), CROSSOVER_NAME " " + juce::String(i + 1), normRange, crossoverDefaults[i]);
+        params.push_back(std::move(crossoverParam));
+    }
+    
+    // each band's drive goes on top of the main drive
+    for (int band = 0; band < 4; ++band)
+    {
+        auto bandName = "Band " + juce::String(band + 1) + " ";
+        
+        auto bandDriveParam = std::make_unique<juce::AudioParameterFloat>(BANDDRIVE_ID + juce::String(band + 1), bandName + BANDDRIVE_NAME, 1.f, 25.0f, 1.f);
+        params.push_back(std::move(bandDriveParam));
+        
+        auto bandTypeParam = std::make_unique<juce::AudioParameterChoice>(BANDTYPE_ID + juce::String(band + 1), bandName + BANDTYPE_NAME, ShaperAlgorithms::getNames(), ShaperAlgorithms::arctan);
+        params.push_back(std::move(bandTypeParam));
+        
+        auto bandLevelParam = std::make_unique<juce::AudioParameterFloat>(BANDLEVEL_ID + juce::String(band + 1), bandName + BANDLEVEL_NAME, -24.0f, 12.0f, 0.0f);
+        params.push_back(std::move(bandLevelParam));
+    }
+    
+    // the state variable filters follow fast cutoff sweeps without clicks, the biquads are cheaper when the cutoff sits still
+    auto filterModeParam = std::make_unique<juce::AudioParameterChoice>(FILTERMODE_ID, FILTERMODE_NAME, juce::StringArray { "Biquad", "State Variable" }, 0);
+    params.push_back(std::move(filterModeParam));
+    
+    // input below this for longer than the filters ring puts the processing to sleep, digital silence always counts
+    auto sleepThresholdParam = std::make_unique<juce::AudioParameterFloat>(SLEEPTHRESHOLD_ID, SLEEPTHRESHOLD_NAME, -150.0f, -60.0f, -100.0f);
+    params.push_back(std::move(sleepThresholdParam));
+    
+    // does nothing until an impulse response has been loaded
+    auto cabinetParam = std::make_unique<juce::AudioParameterBool>(CABINET_ID, CABINET_NAME, false);
+    params.push_back(std::move(cabinetParam));
+    
+    // the biquads' slope, each step adds another section to both cascades
+    auto slopeParam = std::make_unique<juce::AudioParameterChoice>(SLOPE_ID, SLOPE_NAME, juce::StringArray { "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct" }, 0);
+    params.push_back(std::move(slopeParam));
+    
+    // the default is the fixed Q the filters had before this was a parameter
+    auto resonanceRange = juce::NormalisableRange<float>(0.5f, 10.0f);
+    resonanceRange.setSkewForCentre(2.0f);
+    
+    auto resonanceParam = std::make_unique<juce::AudioParameterFloat>(RESONANCE_ID, RESONANCE_NAME, resonanceRange, 1.0f);
+    params.push_back(std::move(resonanceParam));
     
 
     return { params.begin(), params.end() };
@@ -106,31 +280,122 @@ bool VenomDistortionAudioProcessor::isMidiEffect() const
 
 double VenomDistortionAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return computeTailSeconds (oversamplingLatency);
+}
+
+double VenomDistortionAudioProcessor::computeTailSeconds (int latencySamples) const
+{
+    // the lowest filter frequency rings longest, and a sharper filter for longer still: the filters'
+    // sharpest section counts at its frequency divided by how far its Q is over a Butterworth's
+    auto numSections = filterModeParam->load() > 0.5f ? 1 : (int) slopeParam->load() + 1;
+    auto butterworthQ = 1.0 / (2.0 * std::cos (juce::MathConstants<double>::pi * (2 * numSections - 1) / (4.0 * numSections)));
+    auto sharpestQ = butterworthQ * resonanceParam->load() * std::sqrt (2.0);
+    
+    auto lowest = (float) (juce::jmin (cutoffParam->load(), lowcutParam->load()) / juce::jmax (1.0, sharpestQ * std::sqrt (2.0)));
+    auto numBands = (int) bandsParam->load() + 1;
+    
+    // the crossovers' Linkwitz-Riley sections are two Butterworths in series, which ring a little
+    // longer, so they count at half their frequency
+    for (int i = 0; i < numBands - 1; ++i)
+        lowest = juce::jmin (lowest, crossoverParams[(size_t) i]->load() * 0.5f);
+    
+    // a Butterworth's ringing decays as exp (-2 pi f t / sqrt 2), this is how long it takes to
+    // fall from full scale to the sleep threshold
+    auto decayNepers = -sleepThresholdParam->load() / 20.0 * std::log (10.0);
+    auto ringSeconds = decayNepers / (juce::MathConstants<double>::twoPi * juce::jmax (1.0f, lowest) / std::sqrt (2.0));
+    
+    // on top of that the oversampler's delay, the bitcrusher holding its last sample and the cabinet's response
+    auto cabinetSamples = cabinetParam->load() > 0.5f ? cabinetLength.load() : 0;
+    return ringSeconds + (latencySamples + downsampleParam->load() + cabinetSamples) / lastSampleRate.load();
 }
 
 int VenomDistortionAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax (1, presetLibrary->getNumPresets());   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                                                            // so this should be at least 1, even if you're not really implementing programs.
 }
 
 int VenomDistortionAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void VenomDistortionAudioProcessor::setCurrentProgram (int index)
 {
+    loadProgram (index);
 }
 
 const juce::String VenomDistortionAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetLibrary->getName (index);
 }
 
 void VenomDistortionAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    // factory presets keep their names
+    presetLibrary->renameUserPreset (index, newName);
+}
+
+std::vector<PresetLibrary::FactoryPreset> VenomDistortionAudioProcessor::makeFactoryPresets()
+{
+    // anything a preset doesn't list is left at its default
+    return {
+        { "Init", {} },
+        { "Warm Drive", { { DRIVE_ID, 4.0f }, { OUTPUT_ID, -3.0f }, { CUTOFF_ID, 9000.0f }, { ANTIALIASING_ID, 1.0f } } },
+        { "Crunch", { { DRIVE_ID, 10.0f }, { TYPE_ID, (float) ShaperAlgorithms::hardclip }, { OUTPUT_ID, -9.0f }, { LOWCUT_ID, 80.0f },
+                      { CUTOFF_ID, 7000.0f }, { OVERSAMPLING_ID, 2.0f } } },
+        { "Fuzz", { { DRIVE_ID, 22.0f }, { TYPE_ID, (float) ShaperAlgorithms::rectifier }, { OUTPUT_ID, -16.0f }, { LOWCUT_ID, 120.0f },
+                    { CUTOFF_ID, 5000.0f }, { OVERSAMPLING_ID, 2.0f } } },
+        { "Parallel Grit", { { DRIVE_ID, 14.0f }, { MIX_ID, 0.35f }, { OUTPUT_ID, -4.0f }, { LOWCUT_ID, 200.0f } } },
+        { "Lo-Fi", { { DRIVE_ID, 3.0f }, { BITS_ID, 8.0f }, { DOWNSAMPLE_ID, 6.0f }, { DITHER_ID, 1.0f }, { CUTOFF_ID, 6000.0f } } },
+        { "Squashed", { { DRIVE_ID, 6.0f }, { COMPTHRESHOLD_ID, -24.0f }, { COMPRATIO_ID, 6.0f }, { COMPATTACK_ID, 3.0f },
+                        { COMPRELEASE_ID, 80.0f }, { COMPMAKEUP_ID, 6.0f }, { OUTPUT_ID, -6.0f } } },
+        { "Multiband Bite", { { BANDS_ID, 2.0f }, { CROSSOVER_ID "1", 250.0f }, { CROSSOVER_ID "2", 2500.0f }, { BANDDRIVE_ID "1", 2.0f },
+                              { BANDDRIVE_ID "2", 8.0f }, { BANDDRIVE_ID "3", 4.0f }, { BANDLEVEL_ID "3", -4.0f }, { OUTPUT_ID, -6.0f } } },
+    };
+}
+
+void VenomDistortionAudioProcessor::loadProgram (int index)
+{
+    auto state = presetLibrary->getState (index);
+    
+    if (state.isEmpty())
+        return;
+    
+    // the audio thread sits on its last settings until the new ones are all in place,
+    // so it never runs a block with half a preset
+    ++presetSequence;
+    
+    StateFormat::read (state.getData(), (int) state.getSize(), getParameters(), treeState.state);
+    
+    int start1, size1, start2, size2;
+    presetQueue.prepareToWrite (1, start1, size1, start2, size2);
+    
+    // if the queue is full the new values still arrive through the parameters, just without a crossfade
+    if (size1 + size2 > 0)
+    {
+        presetQueueData[size1 > 0 ? start1 : start2] = takeParameterSnapshot();
+        presetQueue.finishedWrite (1);
+    }
+    
+    ++presetSequence;
+    currentProgram = index;
+    updateHostDisplay();
+}
+
+bool VenomDistortionAudioProcessor::saveUserPreset (const juce::String& name)
+{
+    juce::MemoryBlock state;
+    getStateInformation (state);
+    
+    auto index = presetLibrary->saveUserPreset (name, state);
+    
+    if (index < 0)
+        return false;
+    
+    currentProgram = index;
+    updateHostDisplay();
+    return true;
 }
 
 //==============================================================================
@@ -139,25 +404,62 @@ void VenomDistortionAudioProcessor::prepareToPlay (double sampleRate, int sample
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     lastSampleRate = sampleRate;
+    processingStats.resetSummary();
+    spectrumAnalyser.setSampleRate (sampleRate);
     
         
         juce::dsp::ProcessSpec spec;
         spec.sampleRate = sampleRate;
         spec.maximumBlockSize = samplesPerBlock;
-        spec.numChannels = getTotalNumOutputChannels();
+        spec.numChannels = (juce::uint32) juce::jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+    
+        auto params = takeParameterSnapshot();
         
-     
-        lowPassFilter.prepare(spec);
-        lowPassFilter.reset();
+        // any preset change still queued is already in the parameters, there's nothing to fade from
+        presetQueue.reset();
+        silenceDetector.reset();
+        lastParameters = params;
+        crossfadeSamplesRemaining = 0;
+        crossfadeLength = juce::jmax (1, juce::roundToInt (sampleRate * 0.05));
+        activeEngine = 0;
+        
+        if (isUsingDoublePrecision())
+        {
+            for (auto& engine : doubleEngines)
+                engine.prepare (spec, params);
+            
+            doubleCrossfadeBuffer.setSize ((int) spec.numChannels, samplesPerBlock);
+            oversamplingLatency = doubleEngines[activeEngine].getLatencySamples();
+        }
+        else
+        {
+            for (auto& engine : floatEngines)
+                engine.prepare (spec, params);
+            
+            floatCrossfadeBuffer.setSize ((int) spec.numChannels, samplesPerBlock);
+            oversamplingLatency = floatEngines[activeEngine].getLatencySamples();
+        }
     
-        highPassFilter.prepare(spec);
-        highPassFilter.reset();
+        setLatencySamples (oversamplingLatency);
+        
+        // a response resampled for another rate is no use to the engines now
+        {
+            const juce::ScopedLock sl (cabinetFileLock);
+            
+            if (cabinetRequestRate != sampleRate)
+                requestCabinet (sampleRate);
+        }
 }
 
 void VenomDistortionAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    for (auto& engine : floatEngines)
+        engine.reset();
+    
+    for (auto& engine : doubleEngines)
+        engine.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -167,10 +469,9 @@ bool VenomDistortionAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // any layout works, from mono up to surround and ambisonics, every channel gets the same
+    // processing and the engine packs wide buses into SIMD lanes for the filters
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -184,17 +485,174 @@ bool VenomDistortionAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
 }
 #endif
 
-void VenomDistortionAudioProcessor::updateFilter()
+DistortionParameters VenomDistortionAudioProcessor::takeParameterSnapshot() const
 {
-    float lpfreq = *treeState.getRawParameterValue("cutoff");
-    float hpfreq = *treeState.getRawParameterValue("lowcut");
+    DistortionParameters snapshot;
     
-    *lowPassFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(lastSampleRate, lpfreq, 1.0);
+    //add 3 to the input bc algorithm makes starting volume slightly lower
+    snapshot.inputGain = juce::Decibels::decibelsToGain (inputParam->load() + 3.0f);
+    snapshot.drive = driveParam->load();
+    snapshot.outputGain = juce::Decibels::decibelsToGain (outputParam->load());
+    snapshot.mix = mixParam->load();
+    snapshot.cutoff = cutoffParam->load();
+    snapshot.lowcut = lowcutParam->load();
+    snapshot.resonance = resonanceParam->load();
+    snapshot.filterSections = (int) slopeParam->load() + 1;
+    snapshot.shaper = juce::jlimit (0, ShaperAlgorithms::numTypes - 1, (int) typeParam->load());
+    snapshot.quality = (int) qualityParam->load();
+    snapshot.cubicTable = cubicParam->load() > 0.5f;
+    snapshot.stateVariableFilters = filterModeParam->load() > 0.5f;
+    snapshot.antialiasing = (int) antialiasingParam->load();
+    snapshot.crushBits = bitsParam->load();
+    snapshot.downsampling = downsampleParam->load();
+    snapshot.dither = ditherParam->load() > 0.5f;
+    snapshot.crushBeforeShaper = crushPositionParam->load() < 0.5f;
+    snapshot.compressor.thresholdDecibels = compThresholdParam->load();
+    snapshot.compressor.ratio = compRatioParam->load();
+    snapshot.compressor.attackMs = compAttackParam->load();
+    snapshot.compressor.releaseMs = compReleaseParam->load();
+    snapshot.compressor.makeupDecibels = compMakeupParam->load();
+    snapshot.compressor.rms = compDetectorParam->load() > 0.5f;
+    snapshot.compressor.link = compLinkParam->load();
+    snapshot.compressBeforeShaper = compPositionParam->load() < 0.5f;
+    snapshot.cabinet = cabinetParam->load() > 0.5f;
+    snapshot.numBands = (int) bandsParam->load() + 1;
+    
+    for (size_t i = 0; i < crossoverParams.size(); ++i)
+        snapshot.crossovers[i] = crossoverParams[i]->load();
+    
+    for (size_t band = 0; band < snapshot.bands.size(); ++band)
+    {
+        snapshot.bands[band].drive = bandDriveParams[band]->load();
+        snapshot.bands[band].shaper = juce::jlimit (0, ShaperAlgorithms::numTypes - 1, (int) bandTypeParams[band]->load());
+        snapshot.bands[band].level = juce::Decibels::decibelsToGain (bandLevelParams[band]->load());
+    }
+    
+    auto factor = (int) oversamplingParam->load();
+    auto filterType = (int) osFilterParam->load();
+    snapshot.oversampler = factor == 0 ? -1 : filterType * DistortionEngine<float>::maxOversamplingFactor + factor - 1;
+    
+    return snapshot;
+}
+
+void VenomDistortionAudioProcessor::setMeteringEnabled (bool shouldBeEnabled)
+{
+    // start from nothing rather than whatever was left over from the last time the meters ran
+    if (shouldBeEnabled)
+    {
+        inputMeter.read();
+        outputMeter.read();
+        readGainReduction();
+    }
     
-    *highPassFilter.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(lastSampleRate, hpfreq, 1.0);
+    meteringEnabled = shouldBeEnabled;
+}
+
+void VenomDistortionAudioProcessor::setCabinetImpulseResponse (const juce::File& file)
+{
+    treeState.state.setProperty (CABINETIR_ID, file.getFullPathName(), nullptr);
+}
+
+juce::File VenomDistortionAudioProcessor::getCabinetImpulseResponse() const
+{
+    auto path = treeState.state[CABINETIR_ID].toString();
+    return juce::File::isAbsolutePath (path) ? juce::File (path) : juce::File();
+}
+
+void VenomDistortionAudioProcessor::valueTreePropertyChanged (juce::ValueTree& tree, const juce::Identifier& property)
+{
+    if (tree == treeState.state && property == juce::Identifier (CABINETIR_ID))
+        loadCabinet();
+}
+
+void VenomDistortionAudioProcessor::valueTreeRedirected (juce::ValueTree&)
+{
+    // an old XML state replaces the whole tree
+    loadCabinet();
+}
+
+void VenomDistortionAudioProcessor::changeListenerCallback (juce::ChangeBroadcaster*)
+{
+    updateHostDisplay();
+}
+
+void VenomDistortionAudioProcessor::loadCabinet()
+{
+    {
+        const juce::ScopedLock sl (cabinetFileLock);
+        cabinetFile = getCabinetImpulseResponse();
+    }
+    
+    requestCabinet (lastSampleRate);
+}
+
+void VenomDistortionAudioProcessor::requestCabinet (double sampleRate)
+{
+    const juce::ScopedLock sl (cabinetFileLock);
+    auto request = ++cabinetRequested;
+    cabinetRequestRate = sampleRate;
+    
+    // read, trimmed and resampled once on the loader's thread, an unreadable file unloads the cabinet
+    impulseResponseLoader->load (this, cabinetFile, sampleRate, [this, request] (ImpulseResponseLoader::ResponsePtr response)
+    {
+        if (request != cabinetRequested)
+            return;
+        
+        // only the pair for the current precision is playing, but the others would need it after a switch
+        for (auto& engine : floatEngines)
+            engine.setCabinet (response);
+        
+        for (auto& engine : doubleEngines)
+            engine.setCabinet (response);
+        
+        cabinetDelivered = request;
+    });
+}
+
+bool VenomDistortionAudioProcessor::isCabinetReady()
+{
+    if (cabinetParam->load() < 0.5f)
+        return true;
+    
+    if (cabinetDelivered != cabinetRequested)
+        return false;
+    
+    auto ready = isUsingDoublePrecision() ? doubleEngines[activeEngine].updateCabinet()
+                                          : floatEngines[activeEngine].updateCabinet();
+    
+    cabinetLength = isUsingDoublePrecision() ? doubleEngines[activeEngine].getCabinetLength()
+                                             : floatEngines[activeEngine].getCabinetLength();
+    return ready;
+}
+
+void VenomDistortionAudioProcessor::timerCallback()
+{
+    if (latencyChanged.exchange (false))
+        setLatencySamples (oversamplingLatency);
+    
+    processingStats.update();
+}
+
+bool VenomDistortionAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
 }
 
 void VenomDistortionAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    process (buffer, floatEngines, floatCrossfadeBuffer);
+}
+
+void VenomDistortionAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    process (buffer, doubleEngines, doubleCrossfadeBuffer);
+}
+
+template <typename SampleType>
+void VenomDistortionAudioProcessor::process (juce::AudioBuffer<SampleType>& buffer, DistortionEngine<SampleType> (&engines)[2],
+                                             juce::AudioBuffer<SampleType>& crossfadeBuffer)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -204,114 +662,221 @@ void VenomDistortionAudioProcessor::processBlock (juce::AudioBuffer<float>& buff
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-
-    // copy samples for a dry signal, split into L and R instead of doing for(#channels) bc creating a cleanSignal array only works in mono
-    float *cleanSignalL = new float[buffer.getNumSamples()];
-    float *cleanSignalR = new float[buffer.getNumSamples()];
+    // the sequence is read before the queue: once it's even again, the preset written under it is in the queue
+    auto sequence = presetSequence.load();
     
+    int start1, size1, start2, size2;
+    presetQueue.prepareToRead (presetQueue.getNumReady(), start1, size1, start2, size2);
+    auto presetChanged = size1 + size2 > 0;
     
-        auto* channelDataL = buffer.getWritePointer (0);
-        auto* channelDataR = buffer.getWritePointer (1);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            cleanSignalL[sample] = channelDataL[sample];
-            cleanSignalR[sample] = channelDataR[sample];
-        }
+    // read every parameter once, nothing below touches the atomics. A preset change brings its
+    // own complete snapshot, and while one is being written the last settings carry on
+    DistortionParameters params;
+    auto held = false;
     
-    // apply distortion processing to channel data
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    if (presetChanged)
     {
-        auto* channelData = buffer.getWritePointer (channel);
-        auto sliderInputValue = treeState.getRawParameterValue (INPUT_ID);
-        auto sliderDriveValue = treeState.getRawParameterValue (DRIVE_ID);
-        auto sliderOutputValue = treeState.getRawParameterValue (OUTPUT_ID);
-        
-        auto hardclipBool = treeState.getRawParameterValue("hardclip");
-        
+        params = presetQueueData[size2 > 0 ? start2 + size2 - 1 : start1 + size1 - 1];
+    }
+    else if ((sequence & 1) == 0)
+    {
+        // a preset write that started while this was being read could have torn it
+        params = takeParameterSnapshot();
+        held = presetSequence.load() != sequence;
+    }
+    else
+    {
+        held = true;
+    }
+    
+    if (held)
+        params = lastParameters;
+    
+    presetQueue.finishedRead (size1 + size2);
+    
+    if (presetChanged)
+    {
+        // the outgoing engine carries on with the settings it had while the other one fades in
+        crossfadeParameters = lastParameters;
+        activeEngine ^= 1;
+        engines[activeEngine].jumpTo (params);
+        crossfadeSamplesRemaining = crossfadeLength;
+    }
+    
+    lastParameters = params;
+    auto& engine = engines[activeEngine];
+    
+    auto metering = meteringEnabled.load();
+    
+    if (metering)
+        inputMeter.measure (juce::dsp::AudioBlock<SampleType> (buffer), DistortionKernels::getKernels<SampleType>());
+    
+    spectrumAnalyser.push (SpectrumAnalyser::pre, juce::dsp::AudioBlock<SampleType> (buffer));
+    
+    // silent input skips the chain once the tail has died away, waking at the first loud sample.
+    // Whatever is skipped comes out as silence. The threshold is for what comes out of the gains
+    // in front of the shaper, so hiss that drive would make audible keeps the chain awake. The dry
+    // path is never quieter than the input, hence the floor of 1
+    auto numSamples = buffer.getNumSamples();
+    auto sleepThreshold = (SampleType) (juce::Decibels::decibelsToGain (sleepThresholdParam->load(), -200.0f)
+                                          / juce::jmax (1.0f, params.getSmallSignalGain()));
+    auto tailSamples = (int) std::ceil (computeTailSeconds (engine.getLatencySamples()) * lastSampleRate.load());
+    auto samplesToSkip = silenceDetector.getSamplesToSkip (buffer, sleepThreshold, tailSamples);
+    
+    if (samplesToSkip > 0)
+        buffer.clear (0, samplesToSkip);
+    
+    auto asleep = samplesToSkip >= numSamples;
+    
+    if (! asleep)
+    {
+        // a view of the rest of the block, which never allocates however many channels there are
+        processEngines (juce::dsp::AudioBlock<SampleType> (buffer).getSubBlock ((size_t) samplesToSkip),
+                        engines, crossfadeBuffer, params);
+    }
+    else
+    {
+        // asleep, the load readout falls to nothing and a pending crossfade has nothing left to fade
+        ProcessingStats::BlockTiming idle;
+        idle.sampleRate = lastSampleRate;
+        idle.numSamples = numSamples;
+        processingStats.push (idle);
+        crossfadeSamplesRemaining = 0;
+    }
+    
+    spectrumAnalyser.push (SpectrumAnalyser::post, juce::dsp::AudioBlock<SampleType> (buffer));
+    cabinetLength = engine.getCabinetLength();
+    
+    if (metering)
+    {
+        outputMeter.measure (juce::dsp::AudioBlock<SampleType> (buffer), DistortionKernels::getKernels<SampleType>());
         
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            //set input volume, add 3 bc algorithm makes starting volume slightly lower
-            channelData[sample] = channelData[sample] * juce::Decibels::decibelsToGain(sliderInputValue->load() + 3);
-            
-            // https://www.youtube.com/watch?v=oIChUOV_0w4
-            // compression at 23:13
-            // bitcrushing at 29:00
+        // the compressor doesn't run while asleep, so there's no reduction to show
+        LevelMeter::storeMax (gainReduction, asleep ? 0.0f : engine.getGainReductionDecibels());
+    }
+    
+    // switching oversampler changes the latency. Posting a message could lock or allocate here,
+    // so the timer picks the flag up and tells the host
+    if (engine.getLatencySamples() != oversamplingLatency)
+    {
+        oversamplingLatency = engine.getLatencySamples();
+        latencyChanged = true;
+    }
+}
 
-            
-            //hardclipper
-            if (hardclipBool->load() == true)
-            {
-            algorithm = juce::jlimit (-1.f, 1.f, channelData[sample] * sliderDriveValue->load());
-            }
-            
-            //Arctan
-            else if (hardclipBool->load() == false)
-            {
-                algorithm = (2.0f/juce::float_Pi) * atan(channelData[sample] * sliderDriveValue->load());
-            }
-            
-            
-            //rectifier
-            //algorithm = std::abs( channelData[sample] * sliderDriveValue->load());
-            
-            // apply distortion
-            channelData[sample] = algorithm * juce::Decibels::decibelsToGain(sliderOutputValue->load());
-            
-            
-        }
+template <typename SampleType>
+void VenomDistortionAudioProcessor::processEngines (juce::dsp::AudioBlock<SampleType> block, DistortionEngine<SampleType> (&engines)[2],
+                                                    juce::AudioBuffer<SampleType>& crossfadeBuffer, const DistortionParameters& params)
+{
+    auto& engine = engines[activeEngine];
+    auto crossfading = crossfadeSamplesRemaining > 0;
+    
+    // the crossfade buffer is sized in prepareToPlay for the whole block, the outgoing engine gets a copy
+    auto outgoingBlock = juce::dsp::AudioBlock<SampleType> (crossfadeBuffer).getSubsetChannelBlock (0, block.getNumChannels())
+                                                                          .getSubBlock (0, block.getNumSamples());
+    
+    if (crossfading)
+    {
+        outgoingBlock.copyFrom (block);
+        engines[activeEngine ^ 1].process (outgoingBlock, crossfadeParameters);
     }
     
-    // process filtering
-    juce::dsp::AudioBlock <float> block (buffer);
-    lowPassFilter.process(juce::dsp::ProcessContextReplacing<float> (block));
-    highPassFilter.process(juce::dsp::ProcessContextReplacing<float> (block));
-    updateFilter();
+    engine.process (block, params);
+    
+    // while a crossfade runs both engines do a full block's work, and the load has to show both
+    auto timing = engine.getLastTiming();
+    
+    if (crossfading)
+    {
+        const auto& outgoing = engines[activeEngine ^ 1].getLastTiming();
+        
+        for (int stage = 0; stage < ProcessingStats::numStages; ++stage)
+            timing.stageTicks[stage] += outgoing.stageTicks[stage];
+    }
     
-    // mixing bewtween dry signal and processed signal
-    auto sliderMixValue = treeState.getRawParameterValue (MIX_ID);
+    processingStats.push (timing);
     
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+    if (crossfading)
+    {
+        // both engines shape the same input, so a linear fade keeps the level steady
+        auto numSamples = (int) block.getNumSamples();
+        auto faded = crossfadeLength - crossfadeSamplesRemaining;
+        
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
         {
-            channelDataL[sample] = (1.f - sliderMixValue->load()) * cleanSignalL[sample] + sliderMixValue->load() * channelDataL[sample];
+            auto* incoming = block.getChannelPointer (channel);
+            auto* outgoing = outgoingBlock.getChannelPointer (channel);
             
-            channelDataR[sample] = (1.f - sliderMixValue->load()) * cleanSignalR[sample] + sliderMixValue->load() * channelDataR[sample];
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                auto amount = (SampleType) juce::jmin (1.0, (double) (faded + sample) / (double) crossfadeLength);
+                incoming[sample] = outgoing[sample] + amount * (incoming[sample] - outgoing[sample]);
+            }
         }
-    
+        
+        crossfadeSamplesRemaining = juce::jmax (0, crossfadeSamplesRemaining - numSamples);
+    }
 }
 
 //==============================================================================
 bool VenomDistortionAudioProcessor::hasEditor() const
 {
+   #if VENOM_HEADLESS
+    return false;
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* VenomDistortionAudioProcessor::createEditor()
 {
+   #if VENOM_HEADLESS
+    return nullptr;
+   #else
     return new VenomDistortionAudioProcessorEditor (*this);
     //return new foleys::MagicPluginEditor (magicState);
+   #endif
 }
 
 //==============================================================================
 void VenomDistortionAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
     // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    auto state = treeState.copyState();
-            std::unique_ptr<juce::XmlElement> xml (state.createXml());
-            copyXmlToBinary (*xml, destData);
+    // the parameters are read straight from their objects, the tree only holds the extra properties
+    StateFormat::write (getParameters(), treeState.state, destData);
 }
 
 void VenomDistortionAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    if (StateFormat::isBinaryState (data, sizeInBytes))
+    {
+        StateFormat::read (data, sizeInBytes, getParameters(), treeState.state);
+        return;
+    }
+    
+    // sessions saved before the binary format stored an XML copy of the state tree
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
      
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (treeState.state.getType()))
-            treeState.replaceState (juce::ValueTree::fromXml (*xmlState));
+        {
+            auto state = juce::ValueTree::fromXml (*xmlState);
+            
+            // sessions saved before the type parameter stored hard clip as a bool
+            auto hardclip = state.getChildWithProperty ("id", "hardclip");
+            
+            if (hardclip.isValid() && ! state.getChildWithProperty ("id", TYPE_ID).isValid())
+            {
+                juce::ValueTree type (hardclip.getType());
+                type.setProperty ("id", TYPE_ID, nullptr);
+                type.setProperty ("value", (double) hardclip["value"] > 0.5 ? (int) ShaperAlgorithms::hardclip : (int) ShaperAlgorithms::arctan, nullptr);
+                state.appendChild (type, nullptr);
+            }
+            
+            treeState.replaceState (state);
+        }
 }
 
 //==============================================================================
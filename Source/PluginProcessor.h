@@ -9,6 +9,21 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DistortionEngine.h"
+#include "LevelMeter.h"
+#include "SpectrumAnalyser.h"
+#include "StateFormat.h"
+#include "PresetLibrary.h"
+#include "SilenceDetector.h"
+
+// set to 1 by the command line tools, which build the processor without the editor or the plugin wrappers
+#ifndef VENOM_HEADLESS
+ #define VENOM_HEADLESS 0
+#endif
+
+#if VENOM_HEADLESS && ! defined (JucePlugin_Name)
+ #define JucePlugin_Name "Venom Distortion"
+#endif
 
 #define OUTPUT_ID "output"
 #define OUTPUT_NAME "Output"
@@ -28,10 +43,101 @@
 #define LOWCUT_ID "lowcut"
 #define LOWCUT_NAME "Lowcut"
 
+#define TYPE_ID "type"
+#define TYPE_NAME "Type"
+
+#define QUALITY_ID "quality"
+#define QUALITY_NAME "Shaper Quality"
+
+#define CUBIC_ID "cubic"
+#define CUBIC_NAME "Cubic Table"
+
+#define OVERSAMPLING_ID "oversampling"
+#define OVERSAMPLING_NAME "Oversampling"
+
+#define OSFILTER_ID "osfilter"
+#define OSFILTER_NAME "Oversampling Filter"
+
+#define ANTIALIASING_ID "antialiasing"
+#define ANTIALIASING_NAME "Antialiasing"
+
+#define BITS_ID "bits"
+#define BITS_NAME "Bit Depth"
+
+#define DOWNSAMPLE_ID "downsample"
+#define DOWNSAMPLE_NAME "Downsample"
+
+#define DITHER_ID "dither"
+#define DITHER_NAME "Dither"
+
+#define CRUSHPOSITION_ID "crushposition"
+#define CRUSHPOSITION_NAME "Crusher Position"
+
+#define COMPTHRESHOLD_ID "compthreshold"
+#define COMPTHRESHOLD_NAME "Comp Threshold"
+
+#define COMPRATIO_ID "compratio"
+#define COMPRATIO_NAME "Comp Ratio"
+
+#define COMPATTACK_ID "compattack"
+#define COMPATTACK_NAME "Comp Attack"
+
+#define COMPRELEASE_ID "comprelease"
+#define COMPRELEASE_NAME "Comp Release"
+
+#define COMPMAKEUP_ID "compmakeup"
+#define COMPMAKEUP_NAME "Comp Makeup"
+
+#define COMPDETECTOR_ID "compdetector"
+#define COMPDETECTOR_NAME "Comp Detector"
+
+#define COMPLINK_ID "complink"
+#define COMPLINK_NAME "Comp Link"
+
+#define COMPPOSITION_ID "compposition"
+#define COMPPOSITION_NAME "Comp Position"
+
+#define BANDS_ID "bands"
+#define BANDS_NAME "Bands"
+
+// the crossover and per-band parameters are numbered from 1, "crossover1", "banddrive1" and so on
+#define CROSSOVER_ID "crossover"
+#define CROSSOVER_NAME "Crossover"
+
+#define BANDDRIVE_ID "banddrive"
+#define BANDDRIVE_NAME "Drive"
+
+#define BANDTYPE_ID "bandtype"
+#define BANDTYPE_NAME "Type"
+
+#define BANDLEVEL_ID "bandlevel"
+#define BANDLEVEL_NAME "Level"
+
+#define FILTERMODE_ID "filtermode"
+#define FILTERMODE_NAME "Filter Mode"
+
+#define SLEEPTHRESHOLD_ID "sleepthreshold"
+#define SLEEPTHRESHOLD_NAME "Sleep Threshold"
+
+#define CABINET_ID "cabinet"
+#define CABINET_NAME "Cabinet"
+
+#define SLOPE_ID "slope"
+#define SLOPE_NAME "Slope"
+
+#define RESONANCE_ID "resonance"
+#define RESONANCE_NAME "Resonance"
+
+// not a parameter, the impulse response's full path is a property of the state tree
+#define CABINETIR_ID "cabinetIR"
+
 //==============================================================================
 /**
 */
-class VenomDistortionAudioProcessor  : public juce::AudioProcessor
+class VenomDistortionAudioProcessor  : public juce::AudioProcessor,
+                                       private juce::ValueTree::Listener,
+                                       private juce::ChangeListener,
+                                       private juce::Timer
 {
 public:
     
@@ -49,6 +155,9 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -81,25 +190,170 @@ public:
 //    
 //    float mix {0.0f};
     
-    void updateFilter();
-    
     juce::AudioProcessorValueTreeState treeState;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     
     juce::AudioParameterChoice *prmType;
     
+    // per-stage timings of every block, drained by the timer. The editor's CPU readout and the
+    // headless tools read it from here
+    ProcessingStats& getProcessingStats() noexcept     { return processingStats; }
+    
+    // input and output levels and the compressor's gain reduction, only measured while the
+    // editor has metering switched on so a closed editor costs nothing
+    void setMeteringEnabled (bool shouldBeEnabled);
+    LevelMeter& getInputMeter() noexcept       { return inputMeter; }
+    LevelMeter& getOutputMeter() noexcept      { return outputMeter; }
+    
+    // the deepest gain reduction since the last call, in dB
+    float readGainReduction() noexcept         { return gainReduction.exchange (0.0f); }
+    
+    // the editor starts and stops it, the audio thread only feeds it while it's running
+    SpectrumAnalyser& getSpectrumAnalyser() noexcept     { return spectrumAnalyser; }
+    
+    // the programs are the factory presets followed by the user's, see loadProgram
+    PresetLibrary& getPresetLibrary() noexcept     { return *presetLibrary; }
+    
+    // saves the current settings as a user preset and makes it the current program, message thread only
+    bool saveUserPreset (const juce::String& name);
+    
+    // stores the path in the state and loads it into the cabinet stage, the convolution is built in the background
+    void setCabinetImpulseResponse (const juce::File& file);
+    juce::File getCabinetImpulseResponse() const;
+    
+    /** For offline renders, which mustn't start before the response is in place. Call it after
+        prepareToPlay from the thread that processes, never during a block. Returns true once the
+        playing engine has the current response, or when the cabinet is off or has nothing loaded.
+    */
+    bool isCabinetReady();
+    
     //foleys::MagicProcessorState magicState { *this, treeState };
 
 
 private:
     
-    juce::dsp::ProcessorDuplicator <juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients <float>> lowPassFilter;
+    // reports a changed oversampling latency to the host and drains the processing stats. The
+    // filters don't need it, the engines retune them from each block's parameters
+    void timerCallback() override;
     
-    juce::dsp::ProcessorDuplicator <juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients <float>> highPassFilter;
-
+    // the impulse response follows the state's property, whether it's set here, by a preset or by the host
+    void valueTreePropertyChanged (juce::ValueTree& tree, const juce::Identifier& property) override;
+    void valueTreeRedirected (juce::ValueTree& tree) override;
+    void loadCabinet();
+    
+    // asks the loader for the current file at the given rate, and hands the result to every engine
+    void requestCabinet (double sampleRate);
+    
+    // another instance saved or renamed a user preset, so the host's program list is out of date
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+    
+    DistortionParameters takeParameterSnapshot() const;
+    
+    // how long the chain keeps ringing after its input falls below the sleep threshold
+    double computeTailSeconds (int latencySamples) const;
+    
+    static std::vector<PresetLibrary::FactoryPreset> makeFactoryPresets();
+    
+    // applies a preset on the message thread and hands the audio thread the new settings as a whole
+    void loadProgram (int index);
+    
+    // shared by both processBlock overloads
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer, DistortionEngine<SampleType> (&engines)[2],
+                  juce::AudioBuffer<SampleType>& crossfadeBuffer);
+    
+    // the active engine, and while a preset change fades in the outgoing one as well
+    template <typename SampleType>
+    void processEngines (juce::dsp::AudioBlock<SampleType> block, DistortionEngine<SampleType> (&engines)[2],
+                         juce::AudioBuffer<SampleType>& crossfadeBuffer, const DistortionParameters& params);
+    
+    // only the pair matching the host's processing precision is prepared. One engine runs at a time,
+    // the other takes over on a preset change while the first fades out on the old settings
+    DistortionEngine<float> floatEngines[2];
+    DistortionEngine<double> doubleEngines[2];
+    juce::AudioBuffer<float> floatCrossfadeBuffer;
+    juce::AudioBuffer<double> doubleCrossfadeBuffer;
+    int activeEngine = 0;
+    
+    // a sequence lock around writing a preset's values: odd while they're being written. A snapshot
+    // only counts if the count was even and didn't move while it was taken, otherwise the audio thread
+    // keeps its last settings. The complete new settings come through the queue, which it never waits on
+    std::atomic<juce::uint32> presetSequence { 0 };
+    static constexpr int presetQueueSize = 4;
+    juce::AbstractFifo presetQueue { presetQueueSize };
+    DistortionParameters presetQueueData[presetQueueSize];
+    
+    // skips the chain once the input has been silent for longer than the tail
+    SilenceDetector silenceDetector;
+    
+    // audio thread only
+    DistortionParameters lastParameters, crossfadeParameters;
+    int crossfadeLength = 0, crossfadeSamplesRemaining = 0;
+    
+    // bump this whenever makeFactoryPresets changes, so the factory bank on disk is rebuilt
+    static constexpr int factoryPresetRevision = 1;
+    
+    // one library for every instance in the process
+    juce::SharedResourcePointer<PresetLibrary> presetLibrary;
+    int currentProgram = 0;
+    
+    std::atomic<int> oversamplingLatency { 0 };
+    std::atomic<bool> latencyChanged { false };
+    
+    ProcessingStats processingStats;
+    
+    LevelMeter inputMeter, outputMeter;
+    std::atomic<float> gainReduction { 0.0f };
+    std::atomic<bool> meteringEnabled { false };
+    
+    SpectrumAnalyser spectrumAnalyser;
+       
+    std::atomic<float>* inputParam = nullptr;
+    std::atomic<float>* driveParam = nullptr;
+    std::atomic<float>* outputParam = nullptr;
+    std::atomic<float>* mixParam = nullptr;
+    std::atomic<float>* cutoffParam = nullptr;
+    std::atomic<float>* lowcutParam = nullptr;
+    std::atomic<float>* typeParam = nullptr;
+    std::atomic<float>* qualityParam = nullptr;
+    std::atomic<float>* cubicParam = nullptr;
+    std::atomic<float>* oversamplingParam = nullptr;
+    std::atomic<float>* osFilterParam = nullptr;
+    std::atomic<float>* filterModeParam = nullptr;
+    std::atomic<float>* antialiasingParam = nullptr;
+    std::atomic<float>* bitsParam = nullptr;
+    std::atomic<float>* downsampleParam = nullptr;
+    std::atomic<float>* ditherParam = nullptr;
+    std::atomic<float>* crushPositionParam = nullptr;
+    std::atomic<float>* compThresholdParam = nullptr;
+    std::atomic<float>* compRatioParam = nullptr;
+    std::atomic<float>* compAttackParam = nullptr;
+    std::atomic<float>* compReleaseParam = nullptr;
+    std::atomic<float>* compMakeupParam = nullptr;
+    std::atomic<float>* compDetectorParam = nullptr;
+    std::atomic<float>* compLinkParam = nullptr;
+    std::atomic<float>* compPositionParam = nullptr;
+    std::atomic<float>* bandsParam = nullptr;
+    std::array<std::atomic<float>*, 3> crossoverParams {};
+    std::array<std::atomic<float>*, 4> bandDriveParams {}, bandTypeParams {}, bandLevelParams {};
+    std::atomic<float>* sleepThresholdParam = nullptr;
+    std::atomic<float>* cabinetParam = nullptr;
+    std::atomic<float>* slopeParam = nullptr;
+    std::atomic<float>* resonanceParam = nullptr;
+    
+    // kept by the audio thread for the tail length
+    std::atomic<int> cabinetLength { 0 };
+    
+    // the file is copied out of the state on the message thread, so a prepareToPlay on another
+    // thread can ask for it again at a new rate. The cabinet isn't ready while the last request
+    // hasn't come back, and anything older that comes back is ignored
+    juce::SharedResourcePointer<ImpulseResponseLoader> impulseResponseLoader;
+    juce::CriticalSection cabinetFileLock;
+    juce::File cabinetFile;
+    double cabinetRequestRate = 0;
+    std::atomic<int> cabinetRequested { 0 }, cabinetDelivered { 0 };
        
-       float lastSampleRate;
-    float algorithm;
+       std::atomic<double> lastSampleRate { 44100.0 };
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VenomDistortionAudioProcessor)
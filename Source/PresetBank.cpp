@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+    constexpr juce::uint32 bankMagic = 0x426d6e56;   // "VnmB" when read as little endian bytes
+    constexpr int bankVersion = 1;
+}
+
+//==============================================================================
+bool PresetBank::open (const juce::File& fileToOpen)
+{
+    close();
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile> (fileToOpen, juce::MemoryMappedFile::readOnly);
+    auto* data = static_cast<const char*> (mapped->getData());
+    auto size = mapped->getSize();
+
+    if (data == nullptr || size < (size_t) headerSize
+         || juce::ByteOrder::littleEndianInt (data) != bankMagic
+         || juce::ByteOrder::littleEndianShort (data + 4) < 1)
+        return false;
+
+    auto count = (size_t) juce::ByteOrder::littleEndianInt (data + 8);
+
+    if (count > (size - (size_t) headerSize) / (size_t) indexEntrySize)
+        return false;
+
+    // only bounds are checked here, nothing is parsed until it's asked for
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto* entry = data + headerSize + i * (size_t) indexEntrySize;
+        auto nameOffset = (size_t) juce::ByteOrder::littleEndianInt (entry);
+        auto stateOffset = (size_t) juce::ByteOrder::littleEndianInt (entry + 4);
+        auto stateSize = (size_t) juce::ByteOrder::littleEndianInt (entry + 8);
+        auto nameLength = (size_t) juce::ByteOrder::littleEndianShort (entry + 12);
+
+        if (nameOffset > size || nameLength > size - nameOffset || stateOffset > size || stateSize > size - stateOffset
+             || stateSize > (size_t) std::numeric_limits<int>::max())
+            return false;
+    }
+
+    revision = juce::ByteOrder::littleEndianShort (data + 6);
+    numPresets = (int) count;
+    map = std::move (mapped);
+    return true;
+}
+
+void PresetBank::close()
+{
+    map.reset();
+    numPresets = 0;
+    revision = 0;
+}
+
+const char* PresetBank::getIndexEntry (int index) const noexcept
+{
+    if (! juce::isPositiveAndBelow (index, numPresets))
+        return nullptr;
+
+    return static_cast<const char*> (map->getData()) + headerSize + (size_t) index * (size_t) indexEntrySize;
+}
+
+juce::String PresetBank::getName (int index) const
+{
+    auto* entry = getIndexEntry (index);
+
+    if (entry == nullptr)
+        return {};
+
+    auto* data = static_cast<const char*> (map->getData());
+    return juce::String::fromUTF8 (data + juce::ByteOrder::littleEndianInt (entry), (int) juce::ByteOrder::littleEndianShort (entry + 12));
+}
+
+const void* PresetBank::getState (int index, int& sizeInBytes) const noexcept
+{
+    auto* entry = getIndexEntry (index);
+    sizeInBytes = 0;
+
+    if (entry == nullptr)
+        return nullptr;
+
+    sizeInBytes = (int) juce::ByteOrder::littleEndianInt (entry + 8);
+    return static_cast<const char*> (map->getData()) + juce::ByteOrder::littleEndianInt (entry + 4);
+}
+
+juce::Array<PresetBank::Preset> PresetBank::readAll() const
+{
+    juce::Array<Preset> presets;
+
+    for (int i = 0; i < numPresets; ++i)
+    {
+        int size;
+        auto* state = getState (i, size);
+        presets.add ({ getName (i), juce::MemoryBlock (state, (size_t) size) });
+    }
+
+    return presets;
+}
+
+//==============================================================================
+bool PresetBank::write (const juce::File& file, const juce::Array<Preset>& presets, int revision)
+{
+    // lay out the names and states after the index first, so the index can be written in one go
+    juce::MemoryOutputStream data;
+    juce::Array<juce::uint32> nameOffsets, stateOffsets;
+
+    auto dataStart = (juce::uint32) (headerSize + presets.size() * indexEntrySize);
+
+    for (auto& preset : presets)
+    {
+        nameOffsets.add (dataStart + (juce::uint32) data.getDataSize());
+        data.write (preset.name.toRawUTF8(), juce::jmin ((size_t) 0xffff, preset.name.getNumBytesAsUTF8()));
+
+        stateOffsets.add (dataStart + (juce::uint32) data.getDataSize());
+        data.write (preset.state.getData(), preset.state.getSize());
+    }
+
+    juce::TemporaryFile temporary (file);
+
+    {
+        juce::FileOutputStream stream (temporary.getFile());
+
+        if (stream.failedToOpen())
+            return false;
+
+        stream.writeInt ((int) bankMagic);
+        stream.writeShort ((short) bankVersion);
+        stream.writeShort ((short) revision);
+        stream.writeInt (presets.size());
+
+        for (int i = 0; i < presets.size(); ++i)
+        {
+            stream.writeInt ((int) nameOffsets[i]);
+            stream.writeInt ((int) stateOffsets[i]);
+            stream.writeInt ((int) presets.getReference (i).state.getSize());
+            stream.writeShort ((short) juce::jmin ((size_t) 0xffff, presets.getReference (i).name.getNumBytesAsUTF8()));
+            stream.writeShort (0);
+        }
+
+        stream.write (data.getData(), data.getDataSize());
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
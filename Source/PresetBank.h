@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    A bank of presets in one file, memory mapped rather than read. An
+    index at the front holds where each preset's name and state sit in the
+    file, so listing thousands of presets touches only the index and the
+    names, and a preset's state is parsed only when it's loaded. The
+    states are StateFormat blobs. All little endian:
+
+        uint32      magic, "VnmB"
+        uint16      version
+        uint16      revision, for the factory bank to know when it's out of date
+        uint32      number of presets
+        index       per preset: uint32 name offset, uint32 state offset,
+                                uint32 state size, uint16 name length, uint16 unused
+        data        the names (UTF-8) and states the index points at
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PresetBank
+{
+public:
+    struct Preset
+    {
+        juce::String name;
+        juce::MemoryBlock state;
+    };
+
+    PresetBank() = default;
+
+    /** Maps the file and checks the index. Returns false, leaving the bank empty, if the file
+        is missing or malformed.
+    */
+    bool open (const juce::File& fileToOpen);
+    void close();
+
+    int getNumPresets() const noexcept     { return numPresets; }
+    int getRevision() const noexcept       { return revision; }
+
+    juce::String getName (int index) const;
+
+    /** The preset's StateFormat blob, in place in the mapped file. Valid until the bank is closed. */
+    const void* getState (int index, int& sizeInBytes) const noexcept;
+
+    /** Copies every preset out of the file, for rewriting the bank with changes. */
+    juce::Array<Preset> readAll() const;
+
+    /** Writes a bank to a temporary file and then moves it over the target, so a failed
+        write never leaves a broken bank. Close a bank that maps the target first.
+    */
+    static bool write (const juce::File& file, const juce::Array<Preset>& presets, int revision);
+
+private:
+    const char* getIndexEntry (int index) const noexcept;
+
+    static constexpr int headerSize = 12, indexEntrySize = 16;
+
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    int numPresets = 0, revision = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    PresetLibrary.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetLibrary.h"
+
+//==============================================================================
+void PresetLibrary::setFactoryPresets (const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                                       std::vector<FactoryPreset> factoryPresetsToUse, int factoryRevisionToUse)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (factoryPresetsSet)
+        return;
+
+    factoryPresetsSet = true;
+    factoryPresets = std::move (factoryPresetsToUse);
+    factoryRevision = factoryRevisionToUse;
+
+    for (auto* parameter : parameters)
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            defaults.push_back ({ ranged->paramID, ranged->convertFrom0to1 (ranged->getDefaultValue()) });
+}
+
+juce::File PresetLibrary::getPresetDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+             .getChildFile ("Venom Distortion")
+             .getChildFile ("Presets");
+}
+
+//==============================================================================
+void PresetLibrary::openBanks()
+{
+    if (banksOpened)
+        return;
+
+    jassert (factoryPresetsSet);   // the factory list has to be in before anything reads the banks
+
+    banksOpened = true;
+    getPresetDirectory().createDirectory();
+
+    openFactoryBank();
+    userBank.open (getPresetDirectory().getChildFile ("User.venombank"));
+}
+
+void PresetLibrary::openFactoryBank()
+{
+    auto file = getPresetDirectory().getChildFile ("Factory.venombank");
+
+    if (factoryBank.open (file) && factoryBank.getRevision() == factoryRevision)
+        return;
+
+    factoryBank.close();
+    auto presets = makeFactoryPresets();
+
+    if (! PresetBank::write (file, presets, factoryRevision) || ! factoryBank.open (file))
+        factoryFallback = presets;
+}
+
+juce::Array<PresetBank::Preset> PresetLibrary::makeFactoryPresets() const
+{
+    juce::Array<PresetBank::Preset> presets;
+
+    for (auto& factoryPreset : factoryPresets)
+    {
+        // every parameter at its default first, so loading a factory preset sets all of them
+        auto values = defaults;
+
+        for (auto& setting : factoryPreset.values)
+        {
+            auto existing = std::find_if (values.begin(), values.end(), [&] (const StateFormat::ParameterValue& v) { return v.id == setting.id; });
+            jassert (existing != values.end());   // a factory preset names a parameter that doesn't exist
+
+            if (existing != values.end())
+                existing->value = setting.value;
+        }
+
+        PresetBank::Preset preset;
+        preset.name = factoryPreset.name;
+        StateFormat::write (values, juce::ValueTree(), preset.state);
+        presets.add (std::move (preset));
+    }
+
+    return presets;
+}
+
+//==============================================================================
+int PresetLibrary::getNumFactoryPresets()
+{
+    const juce::ScopedLock sl (lock);
+    openBanks();
+
+    return factoryFallback.isEmpty() ? factoryBank.getNumPresets() : factoryFallback.size();
+}
+
+int PresetLibrary::getNumPresets()
+{
+    const juce::ScopedLock sl (lock);
+    return getNumFactoryPresets() + userBank.getNumPresets();
+}
+
+bool PresetLibrary::isUserPreset (int index)
+{
+    const juce::ScopedLock sl (lock);
+    return index >= getNumFactoryPresets() && index < getNumPresets();
+}
+
+juce::String PresetLibrary::getName (int index)
+{
+    const juce::ScopedLock sl (lock);
+    auto numFactory = getNumFactoryPresets();
+
+    if (index >= numFactory)
+        return userBank.getName (index - numFactory);
+
+    if (! factoryFallback.isEmpty())
+        return juce::isPositiveAndBelow (index, factoryFallback.size()) ? factoryFallback.getReference (index).name : juce::String();
+
+    return factoryBank.getName (index);
+}
+
+juce::MemoryBlock PresetLibrary::getState (int index)
+{
+    const juce::ScopedLock sl (lock);
+    auto numFactory = getNumFactoryPresets();
+
+    if (index < numFactory && ! factoryFallback.isEmpty())
+        return juce::isPositiveAndBelow (index, factoryFallback.size()) ? factoryFallback.getReference (index).state : juce::MemoryBlock();
+
+    auto& bank = index < numFactory ? factoryBank : userBank;
+    int size;
+    auto* data = bank.getState (index < numFactory ? index : index - numFactory, size);
+
+    return data != nullptr ? juce::MemoryBlock (data, (size_t) size) : juce::MemoryBlock();
+}
+
+//==============================================================================
+int PresetLibrary::saveUserPreset (const juce::String& name, const juce::MemoryBlock& state)
+{
+    const juce::ScopedLock sl (lock);
+    openBanks();
+
+    auto presets = userBank.readAll();
+    auto index = -1;
+
+    for (int i = 0; i < presets.size(); ++i)
+        if (presets.getReference (i).name == name)
+            index = i;
+
+    if (index >= 0)
+    {
+        presets.getReference (index).state = state;
+    }
+    else
+    {
+        presets.add ({ name, state });
+        index = presets.size() - 1;
+    }
+
+    return rewriteUserBank (presets) ? getNumFactoryPresets() + index : -1;
+}
+
+bool PresetLibrary::renameUserPreset (int index, const juce::String& newName)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (! isUserPreset (index))
+        return false;
+
+    auto presets = userBank.readAll();
+    presets.getReference (index - getNumFactoryPresets()).name = newName;
+
+    return rewriteUserBank (presets);
+}
+
+bool PresetLibrary::rewriteUserBank (const juce::Array<PresetBank::Preset>& presets)
+{
+    auto file = getPresetDirectory().getChildFile ("User.venombank");
+
+    // the mapping has to go before the file can be replaced on some systems. This is the only
+    // mapping in the process, so nothing else is holding the file open
+    userBank.close();
+    auto written = PresetBank::write (file, presets, 0);
+    userBank.open (file);
+
+    // every instance's program list, and the host's, need to hear about it
+    sendChangeMessage();
+    return written;
+}
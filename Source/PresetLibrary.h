@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    PresetLibrary.h
+
+    The factory and user presets, as one list with the factory ones first.
+    Each set is a PresetBank file in the user's application data folder.
+    The factory bank is generated from the list the processor passes in,
+    and regenerated whenever that list's revision changes. Saving or
+    renaming a user preset rewrites the user bank and maps it again.
+    Every plugin instance in the process shares one library through a
+    juce::SharedResourcePointer, so each bank is only mapped once and a
+    rewrite never has to replace a file another instance still has mapped.
+    A change message tells every instance when the user presets change.
+    Nothing here is for the audio thread: the processor copies a preset's
+    state out and applies it on the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PresetBank.h"
+#include "StateFormat.h"
+
+class PresetLibrary  : public juce::ChangeBroadcaster
+{
+public:
+    /** A factory preset as the values that differ from the parameters' defaults. */
+    struct FactoryPreset
+    {
+        juce::String name;
+        std::vector<StateFormat::ParameterValue> values;
+    };
+
+    PresetLibrary() = default;
+
+    /** Every instance calls this when it's created. They all have the same parameters and factory
+        list, so only the first call counts. The parameters' defaults are copied, nothing keeps
+        a reference to the instance.
+    */
+    void setFactoryPresets (const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                            std::vector<FactoryPreset> factoryPresetsToUse, int factoryRevisionToUse);
+
+    /** Where both banks live. */
+    static juce::File getPresetDirectory();
+
+    //==============================================================================
+    int getNumPresets();
+    int getNumFactoryPresets();
+    bool isUserPreset (int index);
+
+    juce::String getName (int index);
+
+    /** A copy of the preset's StateFormat blob, empty if there's no such preset. */
+    juce::MemoryBlock getState (int index);
+
+    /** Saves a user preset, replacing any user preset with the same name. Returns its index
+        in the combined list, or -1 if the bank couldn't be written.
+    */
+    int saveUserPreset (const juce::String& name, const juce::MemoryBlock& state);
+
+    /** Only user presets can be renamed. Saving and renaming send a change message. */
+    bool renameUserPreset (int index, const juce::String& newName);
+
+private:
+    // the banks are opened the first time anything asks, not when the plugin is created
+    void openBanks();
+    void openFactoryBank();
+    juce::Array<PresetBank::Preset> makeFactoryPresets() const;
+
+    bool rewriteUserBank (const juce::Array<PresetBank::Preset>& presets);
+
+    juce::CriticalSection lock;
+
+    // every parameter at its default, the starting point for each factory preset
+    std::vector<StateFormat::ParameterValue> defaults;
+    std::vector<FactoryPreset> factoryPresets;
+    int factoryRevision = 0;
+    bool factoryPresetsSet = false;
+
+    bool banksOpened = false;
+    PresetBank factoryBank, userBank;
+
+    // only used if the factory bank can't be written, e.g. to a read-only folder
+    juce::Array<PresetBank::Preset> factoryFallback;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetLibrary)
+};
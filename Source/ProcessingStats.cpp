@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    ProcessingStats.cpp
+
+  ==============================================================================
+*/
+
+#include "ProcessingStats.h"
+
+//==============================================================================
+const char* ProcessingStats::getStageName (int stage) noexcept
+{
+    switch (stage)
+    {
+        case gain:      return "gain";
+        case dynamics:  return "dynamics";
+        case shaper:    return "shaper";
+        case filters:   return "filters";
+        case cabinet:   return "cabinet";
+        case mix:       return "mix";
+        default:        break;
+    }
+
+    return "";
+}
+
+ProcessingStats::ProcessingStats() = default;
+
+ProcessingStats::~ProcessingStats()
+{
+    stopCsv();
+}
+
+//==============================================================================
+void ProcessingStats::push (const BlockTiming& timing) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+    {
+        ++numDropped;
+        return;
+    }
+
+    records[size1 > 0 ? start1 : start2] = timing;
+    fifo.finishedWrite (1);
+}
+
+//==============================================================================
+void ProcessingStats::update()
+{
+    const juce::ScopedLock sl (readerLock);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        addToSummary (records[start1 + i]);
+
+    for (int i = 0; i < size2; ++i)
+        addToSummary (records[start2 + i]);
+
+    fifo.finishedRead (size1 + size2);
+
+    summary.numDropped += numDropped.exchange (0);
+}
+
+ProcessingStats::Summary ProcessingStats::getSummary()
+{
+    update();
+
+    const juce::ScopedLock sl (readerLock);
+    return summary;
+}
+
+void ProcessingStats::resetSummary()
+{
+    const juce::ScopedLock sl (readerLock);
+
+    summary = Summary();
+    totalSeconds = totalDuration = totalSamples = 0;
+    std::fill (std::begin (stageSeconds), std::end (stageSeconds), 0.0);
+}
+
+void ProcessingStats::addToSummary (const BlockTiming& timing)
+{
+    if (timing.numSamples <= 0 || timing.sampleRate <= 0)
+        return;
+
+    double seconds[numStages];
+    auto blockSeconds = 0.0;
+
+    for (int stage = 0; stage < numStages; ++stage)
+    {
+        seconds[stage] = juce::Time::highResolutionTicksToSeconds (timing.stageTicks[stage]);
+        stageSeconds[stage] += seconds[stage];
+        blockSeconds += seconds[stage];
+    }
+
+    auto duration = timing.numSamples / timing.sampleRate;
+    auto load = blockSeconds / duration;
+
+    totalSeconds += blockSeconds;
+    totalDuration += duration;
+    totalSamples += timing.numSamples;
+
+    // weighted by how much audio the block covers, so the smoothing time doesn't depend on the block size
+    summary.currentLoad += (1.0 - std::exp (-duration / 0.3)) * (load - summary.currentLoad);
+    summary.averageLoad = totalSeconds / totalDuration;
+    summary.peakLoad = juce::jmax (summary.peakLoad, load);
+    ++summary.numBlocks;
+
+    for (int stage = 0; stage < numStages; ++stage)
+        summary.stageNanosPerSample[stage] = stageSeconds[stage] * 1.0e9 / totalSamples;
+
+    if (csv != nullptr)
+    {
+        auto row = juce::String (csvRow++) + "," + juce::String (timing.numSamples) + "," + juce::String (timing.sampleRate);
+
+        for (auto s : seconds)
+            row << "," << juce::String (s * 1.0e9, 0);
+
+        row << "," << juce::String (blockSeconds * 1.0e9, 0) << "," << juce::String (load, 5);
+        csv->writeText (row + "\n", false, false, nullptr);
+    }
+}
+
+//==============================================================================
+bool ProcessingStats::startCsv (const juce::File& file)
+{
+    const juce::ScopedLock sl (readerLock);
+
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream> (file);
+
+    if (stream->failedToOpen())
+        return false;
+
+    juce::String header ("block,samples,sample_rate");
+
+    for (int stage = 0; stage < numStages; ++stage)
+        header << "," << getStageName (stage) << "_ns";
+
+    header << ",total_ns,load\n";
+    stream->writeText (header, false, false, nullptr);
+
+    csv = std::move (stream);
+    csvRow = 0;
+    return true;
+}
+
+void ProcessingStats::stopCsv()
+{
+    const juce::ScopedLock sl (readerLock);
+
+    if (csv != nullptr)
+        csv->flush();
+
+    csv.reset();
+}
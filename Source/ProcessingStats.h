@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    ProcessingStats.h
+
+    Per-stage processing cost of every block. The audio thread times its
+    stages with the high resolution clock and pushes one small record per
+    block into a lock-free FIFO. If the FIFO is full the record is dropped
+    and counted, so the audio thread never waits. A reader thread drains it
+    into a running summary, and can write every record to a CSV file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ProcessingStats
+{
+public:
+    /** Where the time in a block goes. */
+    enum Stage
+    {
+        gain = 0,       // the input, drive and output gains
+        dynamics,       // compressor and bitcrusher
+        shaper,         // oversampling, band splitting and the shaper itself
+        filters,
+        cabinet,        // the impulse response, when one is loaded and switched on
+        mix,            // the dry copy and the dry/wet mix
+        numStages
+    };
+
+    static const char* getStageName (int stage) noexcept;
+
+    /** One block's timings, in high resolution ticks so the audio thread never converts anything. */
+    struct BlockTiming
+    {
+        double sampleRate = 0;
+        int numSamples = 0;
+        juce::int64 stageTicks[numStages] {};
+    };
+
+    /** Times the stages of one block. Each lap adds the time since the previous lap (or
+        since construction) to a stage, so a stage can be lapped more than once per block.
+    */
+    class StageClock
+    {
+    public:
+        StageClock (BlockTiming& timingToFill, double sampleRate, int numSamples) noexcept
+            : timing (timingToFill), last (juce::Time::getHighResolutionTicks())
+        {
+            timing = BlockTiming();
+            timing.sampleRate = sampleRate;
+            timing.numSamples = numSamples;
+        }
+
+        void lap (Stage stage) noexcept
+        {
+            auto now = juce::Time::getHighResolutionTicks();
+            timing.stageTicks[stage] += now - last;
+            last = now;
+        }
+
+    private:
+        BlockTiming& timing;
+        juce::int64 last;
+    };
+
+    /** What the reader side has worked out so far. A load of 1 is a block taking as long to
+        process as it lasts, which is the whole realtime budget of a single core.
+    */
+    struct Summary
+    {
+        double currentLoad = 0;                     // smoothed over roughly the last 300 ms
+        double averageLoad = 0, peakLoad = 0;       // since the last reset
+        double stageNanosPerSample[numStages] {};   // since the last reset
+        juce::int64 numBlocks = 0, numDropped = 0;
+    };
+
+    ProcessingStats();
+    ~ProcessingStats();
+
+    //==============================================================================
+    /** Audio thread only. Never blocks or allocates, drops the record if the FIFO is full. */
+    void push (const BlockTiming& timing) noexcept;
+
+    //==============================================================================
+    /** Drains everything pushed so far into the summary and the CSV file, if one is open.
+        Any thread but the audio thread, readers share a lock the audio thread never takes.
+    */
+    void update();
+
+    /** Drains the FIFO, then returns the summary. */
+    Summary getSummary();
+
+    /** Starts the averages and the peak over. */
+    void resetSummary();
+
+    /** Writes a header and then one row per block to the file until stopCsv, replacing
+        anything already there. The rows go through the stream's buffer, so the file is only
+        complete once stopCsv has flushed it. Returns false if the file can't be written.
+    */
+    bool startCsv (const juce::File& file);
+    void stopCsv();
+
+private:
+    void addToSummary (const BlockTiming& timing);
+
+    static constexpr int fifoSize = 1024;
+
+    juce::AbstractFifo fifo { fifoSize };
+    BlockTiming records[fifoSize];
+    std::atomic<int> numDropped { 0 };
+
+    juce::CriticalSection readerLock;
+    Summary summary;
+    double totalSeconds = 0, totalDuration = 0, totalSamples = 0;
+    double stageSeconds[numStages] {};
+
+    std::unique_ptr<juce::FileOutputStream> csv;
+    juce::int64 csvRow = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProcessingStats)
+};
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    SIMDBiquad.cpp
+
+  ==============================================================================
+*/
+
+#include "SIMDBiquad.h"
+
+//==============================================================================
+template <typename SampleType>
+SIMDBiquad<SampleType>::SIMDBiquad()
+{
+    for (auto& section : coefficients)
+        section = new juce::dsp::IIR::Coefficients<SampleType> (1, 0, 0, 1, 0, 0);
+}
+
+template <typename SampleType>
+void SIMDBiquad<SampleType>::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    auto numLanes = Register::size();
+    auto numGroups = (spec.numChannels + numLanes - 1) / numLanes;
+
+    laneFilters.clear();
+
+    for (size_t group = 0; group < numGroups; ++group)
+        for (auto& section : coefficients)
+            laneFilters.add (new juce::dsp::IIR::Filter<Register> (section));
+
+    interleaved = juce::dsp::AudioBlock<Register> (interleavedData, numGroups, spec.maximumBlockSize);
+    reset();
+}
+
+template <typename SampleType>
+void SIMDBiquad<SampleType>::reset() noexcept
+{
+    for (auto* filter : laneFilters)
+        filter->reset();
+}
+
+template <typename SampleType>
+void SIMDBiquad<SampleType>::setCoefficients (const BiquadCascade& cascade) noexcept
+{
+    auto newNumSections = juce::jlimit (1, BiquadCascade::maxSections, cascade.numSections);
+
+    for (int section = 0; section < newNumSections; ++section)
+        std::transform (cascade.sections[(size_t) section].begin(), cascade.sections[(size_t) section].end(),
+                        coefficients[(size_t) section]->getRawCoefficients(), [] (double c) { return (SampleType) c; });
+
+    auto numGroups = (size_t) laneFilters.size() / BiquadCascade::maxSections;
+
+    for (size_t group = 0; group < numGroups; ++group)
+        for (int section = numSections; section < newNumSections; ++section)
+            getFilter (group, section).reset();
+
+    numSections = newNumSections;
+}
+
+template <typename SampleType>
+void SIMDBiquad<SampleType>::process (juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    const auto numLanes = Register::size();
+    const auto numChannels = block.getNumChannels();
+    const auto numSamples = block.getNumSamples();
+
+    jassert (numSamples <= interleaved.getNumSamples());
+    jassert (numChannels <= (size_t) laneFilters.size() / BiquadCascade::maxSections * numLanes);
+
+    for (size_t group = 0; group * numLanes < numChannels; ++group)
+    {
+        auto* lanes = reinterpret_cast<SampleType*> (interleaved.getChannelPointer (group));
+        auto firstChannel = group * numLanes;
+
+        // channel n of the group goes into lane n, spare lanes in the last group run on silence
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            if (firstChannel + lane < numChannels)
+            {
+                auto* source = block.getChannelPointer (firstChannel + lane);
+
+                for (size_t sample = 0; sample < numSamples; ++sample)
+                    lanes[sample * numLanes + lane] = source[sample];
+            }
+            else
+            {
+                for (size_t sample = 0; sample < numSamples; ++sample)
+                    lanes[sample * numLanes + lane] = SampleType();
+            }
+        }
+
+        auto groupBlock = interleaved.getSingleChannelBlock (group).getSubBlock (0, numSamples);
+
+        for (int section = 0; section < numSections; ++section)
+            getFilter (group, section).process (juce::dsp::ProcessContextReplacing<Register> (groupBlock));
+
+        for (size_t lane = 0; lane < numLanes && firstChannel + lane < numChannels; ++lane)
+        {
+            auto* destination = block.getChannelPointer (firstChannel + lane);
+
+            for (size_t sample = 0; sample < numSamples; ++sample)
+                destination[sample] = lanes[sample * numLanes + lane];
+        }
+    }
+}
+
+//==============================================================================
+template class SIMDBiquad<float>;
+template class SIMDBiquad<double>;
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    SIMDBiquad.h
+
+    A cascade of biquads that runs several channels at once, one channel
+    per lane of a juce::dsp::SIMDRegister. A filter's recursion can't be
+    vectorised along time, but it can across channels, so a stereo pair or
+    a wide bus costs one pass per section for each group of 4 (float) or
+    2 (double) channels instead of one per channel. The channels are
+    interleaved once per block and every section runs on the interleaved
+    data, so a steeper slope only adds the sections themselves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Raw b0, b1, b2, a1, a2 coefficients for each section of a cascade, only the first numSections are used. */
+struct BiquadCascade
+{
+    static constexpr int maxSections = 4;
+
+    std::array<std::array<double, 5>, maxSections> sections {};
+    int numSections = 1;
+};
+
+template <typename SampleType>
+class SIMDBiquad
+{
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+
+    SIMDBiquad();
+
+    /** Allocates the lane filters for every section and the interleaving buffer for spec.numChannels. */
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    /** Copies the coefficients in place, safe on the audio thread. Sections that come into use
+        start from silence rather than from whatever they held when they were last used.
+    */
+    void setCoefficients (const BiquadCascade& cascade) noexcept;
+
+    /** Filters every channel of the block in place. */
+    void process (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+private:
+    juce::dsp::IIR::Filter<Register>& getFilter (size_t group, int section) noexcept
+    {
+        return *laneFilters.getUnchecked ((int) group * BiquadCascade::maxSections + section);
+    }
+
+    // every lane group shares one set of coefficients per section
+    std::array<typename juce::dsp::IIR::Coefficients<SampleType>::Ptr, BiquadCascade::maxSections> coefficients;
+    juce::OwnedArray<juce::dsp::IIR::Filter<Register>> laneFilters;
+    int numSections = 1;
+
+    // one interleaved channel per lane group, aligned for the register loads
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<Register> interleaved;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SIMDBiquad)
+};
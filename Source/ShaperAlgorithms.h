@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    ShaperAlgorithms.h
+
+    The registry of waveshaper curves. Each curve is a small functor, and the
+    kernels, lookup tables and the type parameter's choices are all generated
+    from the list at the bottom, so adding a curve means writing one functor
+    and adding it to that list.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace ShaperAlgorithms
+{
+    /** Polynomial arctan approximation.
+
+        Range reduces to [0, 1] with atan(x) = pi/2 - atan(1/x), then evaluates an
+        odd 11th order minimax polynomial. Measured against std::atan over
+        [-1000, 1000] the absolute error is below 2.0e-6 rad, which after the
+        2/pi output scaling of the shaper is below 1.2e-6 (around -118 dBFS).
+        The double version uses the same polynomial, so it has the same bound.
+    */
+    template <typename SampleType>
+    inline SampleType fastAtan (SampleType x) noexcept
+    {
+        auto a = std::abs (x);
+        auto t = juce::jmin (a, SampleType (1)) / juce::jmax (a, SampleType (1));
+        auto t2 = t * t;
+
+        auto p = SampleType (-0.01172120);
+        p = p * t2 + SampleType (0.05265332);
+        p = p * t2 - SampleType (0.11643287);
+        p = p * t2 + SampleType (0.19354346);
+        p = p * t2 - SampleType (0.33262347);
+        p = p * t2 + SampleType (0.99997726);
+        p *= t;
+
+        if (a > SampleType (1))
+            p = juce::MathConstants<SampleType>::halfPi - p;
+
+        return std::copysign (p, x);
+    }
+
+    //==============================================================================
+    /*  A shaper algorithm provides:
+
+          getName()         the name shown in the type parameter
+          process (x)       the curve itself, x already has the drive applied
+          getTableRange()   the lookup tables sample the curve over [-range, range]
+          tail (x)          a cheap closed form for |x| >= range, used by the tables
+          antiderivative1 (x), antiderivative2 (x)
+                            the first and second antiderivatives, zero at x = 0, used by
+                            the antialiased (ADAA) shaper. These are exact, not approximated,
+                            because ADAA divides their differences by tiny input steps
+
+        process has no state and no branches on anything but x, so the generated
+        block kernels leave the compiler free to vectorise them.
+    */
+
+    /** (2 / pi) * atan (x), the original soft clipper. */
+    struct Arctan
+    {
+        static const char* getName() noexcept      { return "Arctan"; }
+        static float getTableRange() noexcept      { return 64.0f; }
+
+        template <typename SampleType>
+        static SampleType process (SampleType x) noexcept
+        {
+            return SampleType (2) / juce::MathConstants<SampleType>::pi * fastAtan (x);
+        }
+
+        // sign (x) - (2 / pi) / x is within 1e-6 of the curve for |x| > 64
+        static float tail (float x) noexcept
+        {
+            return std::copysign (1.0f, x) - (2.0f / juce::MathConstants<float>::pi) / x;
+        }
+
+        // (2 / pi) * (x atan (x) - ln (1 + x^2) / 2)
+        static double antiderivative1 (double x) noexcept
+        {
+            return 2.0 / juce::MathConstants<double>::pi * (x * std::atan (x) - 0.5 * std::log1p (x * x));
+        }
+
+        // (2 / pi) * ((x^2 - 1) atan (x) / 2 + x / 2 - x ln (1 + x^2) / 2)
+        static double antiderivative2 (double x) noexcept
+        {
+            return 1.0 / juce::MathConstants<double>::pi * ((x * x - 1.0) * std::atan (x) + x - x * std::log1p (x * x));
+        }
+    };
+
+    /** clamp (x, -1, 1) */
+    struct HardClip
+    {
+        static const char* getName() noexcept      { return "Hard Clip"; }
+        static float getTableRange() noexcept      { return 2.0f; }
+
+        template <typename SampleType>
+        static SampleType process (SampleType x) noexcept
+        {
+            return juce::jlimit (SampleType (-1), SampleType (1), x);
+        }
+
+        static float tail (float x) noexcept
+        {
+            return std::copysign (1.0f, x);
+        }
+
+        static double antiderivative1 (double x) noexcept
+        {
+            auto a = std::abs (x);
+            return a <= 1.0 ? 0.5 * x * x : a - 0.5;
+        }
+
+        static double antiderivative2 (double x) noexcept
+        {
+            auto a = std::abs (x);
+            return a <= 1.0 ? x * x * x / 6.0 : std::copysign (0.5 * x * x - 0.5 * a + 1.0 / 6.0, x);
+        }
+    };
+
+    /** Full wave rectification into the arctan curve, which doubles every frequency and
+        stays bounded. The DC it adds is taken out by the low cut filter.
+    */
+    struct Rectifier
+    {
+        static const char* getName() noexcept      { return "Rectifier"; }
+        static float getTableRange() noexcept      { return 64.0f; }
+
+        template <typename SampleType>
+        static SampleType process (SampleType x) noexcept
+        {
+            return Arctan::process (std::abs (x));
+        }
+
+        static float tail (float x) noexcept
+        {
+            return Arctan::tail (std::abs (x));
+        }
+
+        // the curve is even, so its first antiderivative is odd and its second is even again
+        static double antiderivative1 (double x) noexcept
+        {
+            return std::copysign (Arctan::antiderivative1 (std::abs (x)), x);
+        }
+
+        static double antiderivative2 (double x) noexcept
+        {
+            return Arctan::antiderivative2 (std::abs (x));
+        }
+    };
+
+    //==============================================================================
+    template <typename... Algorithms>
+    struct List
+    {
+        static constexpr int size = (int) sizeof... (Algorithms);
+    };
+
+    /** Every algorithm, in the order of the type parameter's choices. The Type enum must match. */
+    using All = List<Arctan, HardClip, Rectifier>;
+
+    enum Type
+    {
+        arctan = 0,
+        hardclip,
+        rectifier,
+        numTypes
+    };
+
+    static_assert (All::size == numTypes, "the Type enum and the algorithm list are out of step");
+
+    /** Calls fn (Algorithm(), index) for every algorithm in the list. */
+    template <typename... Algorithms, typename Fn>
+    void forEach (List<Algorithms...>, Fn&& fn)
+    {
+        int index = 0;
+        (void) std::initializer_list<int> { (fn (Algorithms(), index++), 0)... };
+    }
+
+    template <typename Fn>
+    void forEach (Fn&& fn)
+    {
+        forEach (All(), std::forward<Fn> (fn));
+    }
+
+    /** The choices for the type parameter. */
+    inline juce::StringArray getNames()
+    {
+        juce::StringArray names;
+        forEach ([&names] (auto algorithm, int) { names.add (decltype (algorithm)::getName()); });
+        return names;
+    }
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    ShaperTables.h
+
+    Precomputed transfer curves for the table driven shaper mode. The tables
+    are built once per process and shared read-only by every plugin instance
+    through a juce::SharedResourcePointer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ShaperAlgorithms.h"
+
+//==============================================================================
+/** One transfer curve sampled over [-range, range].
+
+    Linear reads go through juce::dsp::LookupTableTransform, cubic reads use a
+    Catmull-Rom spline over a padded copy of the same points. Outside the table
+    range the curve's closed-form tail takes over, so inputs of any size are safe.
+*/
+class ShaperTable
+{
+public:
+    using TailFunction = float (*) (float);
+
+    ShaperTable() = default;
+
+    void initialise (const std::function<float (float)>& curve, TailFunction tailToUse,
+                     float rangeToUse, int numPointsToUse);
+
+    float processSampleLinear (float x) const noexcept
+    {
+        return std::abs (x) < range ? linearTable.processSampleUnchecked (x) : tail (x);
+    }
+
+    float processSampleCubic (float x) const noexcept
+    {
+        if (std::abs (x) >= range)
+            return tail (x);
+
+        auto pos = (x + range) * scaler;
+
+        // just below range, x + range can round up to the full width and land on the last point,
+        // which has no segment after it. The last segment's end point gives the same value
+        auto index = juce::jmin ((int) pos, lastSegment);
+        auto frac = pos - (float) index;
+
+        // cubicPoints is offset by one, so index points at the sample before the segment
+        auto* p = cubicPoints.data() + index;
+
+        return p[1] + 0.5f * frac * (p[2] - p[0]
+                      + frac * (2.0f * p[0] - 5.0f * p[1] + 4.0f * p[2] - p[3]
+                      + frac * (3.0f * (p[1] - p[2]) + p[3] - p[0])));
+    }
+
+    /** Shapes numSamples of data in place, drive is applied before the curve.
+        The tables are float, so double data is looked up at float precision.
+    */
+    template <typename SampleType>
+    void process (SampleType* data, int numSamples, SampleType drive, bool cubic) const noexcept
+    {
+        if (cubic)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = (SampleType) processSampleCubic ((float) (data[i] * drive));
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = (SampleType) processSampleLinear ((float) (data[i] * drive));
+        }
+    }
+
+private:
+    juce::dsp::LookupTableTransform<float> linearTable;
+    std::vector<float> cubicPoints;
+    TailFunction tail = nullptr;
+    float range = 1.0f, scaler = 1.0f;
+    int lastSegment = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (ShaperTable)
+};
+
+//==============================================================================
+/** Every curve in ShaperAlgorithms at every table size. */
+class ShaperTables
+{
+public:
+    /** 512, 4096 and 65536 points, in the same order as the table choices of the shaper quality parameter. */
+    static constexpr int numTableSizes = 3;
+
+    static int getTableSize (int sizeIndex) noexcept;
+
+    ShaperTables();
+
+    const ShaperTable& get (int type, int sizeIndex) const noexcept
+    {
+        jassert (juce::isPositiveAndBelow (type, (int) ShaperAlgorithms::numTypes));
+        jassert (juce::isPositiveAndBelow (sizeIndex, numTableSizes));
+        return tables[type][sizeIndex];
+    }
+
+private:
+    ShaperTable tables[ShaperAlgorithms::numTypes][numTableSizes];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ShaperTables)
+};
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    SilenceDetector.h
+
+    Decides when the processor can stop running the chain. Once the input
+    has stayed below the threshold for longer than the chain's tail, the
+    detector goes to sleep and every block is skipped. When a sample at or
+    above the threshold comes in it wakes up at that sample, so the chain
+    starts exactly where the signal does. While awake it only looks back
+    from the end of each block for the last loud sample, which usually
+    means checking one sample per channel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class SilenceDetector
+{
+public:
+    SilenceDetector() = default;
+
+    void reset() noexcept
+    {
+        silentSamples = 0;
+        asleep = false;
+    }
+
+    bool isAsleep() const noexcept     { return asleep; }
+
+    /** Audio thread, at the top of each block with the input. Returns how many samples at the
+        start of the block can be skipped: none while awake, the whole block while asleep, or
+        the samples before the first loud one when the signal comes back part way through.
+    */
+    template <typename SampleType>
+    int getSamplesToSkip (const juce::AudioBuffer<SampleType>& input, SampleType threshold, int tailSamples) noexcept
+    {
+        auto numSamples = input.getNumSamples();
+
+        if (asleep)
+        {
+            auto firstLoud = numSamples;
+
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                auto* data = input.getReadPointer (channel);
+
+                for (int sample = 0; sample < firstLoud; ++sample)
+                {
+                    if (std::abs (data[sample]) >= threshold)
+                    {
+                        firstLoud = sample;
+                        break;
+                    }
+                }
+            }
+
+            if (firstLoud == numSamples)
+                return numSamples;
+
+            asleep = false;
+            silentSamples = numSamples - 1 - findLastLoud (input, threshold);
+            return firstLoud;
+        }
+
+        auto lastLoud = findLastLoud (input, threshold);
+        silentSamples = lastLoud < 0 ? silentSamples + numSamples : numSamples - 1 - lastLoud;
+
+        // the chain still runs for this block, sleep starts with the next one
+        if (silentSamples > tailSamples)
+            asleep = true;
+
+        return 0;
+    }
+
+private:
+    // -1 if every sample is below the threshold
+    template <typename SampleType>
+    static int findLastLoud (const juce::AudioBuffer<SampleType>& input, SampleType threshold) noexcept
+    {
+        auto lastLoud = -1;
+
+        for (int channel = 0; channel < input.getNumChannels(); ++channel)
+        {
+            auto* data = input.getReadPointer (channel);
+
+            for (int sample = input.getNumSamples(); --sample > lastLoud;)
+            {
+                if (std::abs (data[sample]) >= threshold)
+                {
+                    lastLoud = sample;
+                    break;
+                }
+            }
+        }
+
+        return lastLoud;
+    }
+
+    int silentSamples = 0;
+    bool asleep = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SilenceDetector)
+};
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+//==============================================================================
+SpectrumAnalyser::SpectrumAnalyser()
+    : juce::Thread ("Spectrum Analyser")
+{
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stop();
+}
+
+void SpectrumAnalyser::start()
+{
+    if (running.exchange (true))
+        return;
+
+    // well below the audio thread, and below the message thread too
+    startThread (3);
+}
+
+void SpectrumAnalyser::stop()
+{
+    running = false;
+    stopThread (1000);
+}
+
+void SpectrumAnalyser::setDisplaySize (int width, int height) noexcept
+{
+    displayWidth = width;
+    displayHeight = height;
+}
+
+//==============================================================================
+template <typename SampleType>
+void SpectrumAnalyser::push (Source source, const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    if (! running.load() || block.getNumChannels() == 0)
+        return;
+
+    auto& state = sources[source];
+    auto numChannels = block.getNumChannels();
+    auto scale = SampleType (1) / (SampleType) numChannels;
+
+    int start1, size1, start2, size2;
+    state.fifo.prepareToWrite ((int) block.getNumSamples(), start1, size1, start2, size2);
+
+    auto mixDown = [&] (int destination, int sourceOffset, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            SampleType sum = 0;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                sum += block.getSample ((int) channel, sourceOffset + i);
+
+            state.fifoData[(size_t) (destination + i)] = (float) (sum * scale);
+        }
+    };
+
+    mixDown (start1, 0, size1);
+    mixDown (start2, size1, size2);
+    state.fifo.finishedWrite (size1 + size2);
+}
+
+//==============================================================================
+void SpectrumAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        auto analysed = false;
+
+        for (int source = 0; source < numSources; ++source)
+            analysed = analyse ((Source) source) || analysed;
+
+        auto width = (float) displayWidth.load(), height = (float) displayHeight.load();
+
+        if (analysed && width > 0 && height > 0)
+        {
+            Paths newPaths;
+
+            for (int source = 0; source < numSources; ++source)
+                newPaths.spectra[source] = makePath (sources[source].power, width, height);
+
+            paths.write (newPaths);
+        }
+
+        // the display runs at 30 fps, there's no point analysing much faster than that
+        wait (15);
+    }
+}
+
+bool SpectrumAnalyser::analyse (Source source)
+{
+    auto& state = sources[source];
+
+    int start1, size1, start2, size2;
+    state.fifo.prepareToRead (state.fifo.getNumReady(), start1, size1, start2, size2);
+
+    auto analysed = false;
+
+    auto consume = [&] (int start, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            state.history[(size_t) state.historyIndex] = state.fifoData[(size_t) (start + i)];
+            state.historyIndex = (state.historyIndex + 1) % fftSize;
+
+            if (++state.samplesSinceFrame < hopSize)
+                continue;
+
+            state.samplesSinceFrame = 0;
+
+            // unroll the history oldest first, then window and transform it
+            for (int j = 0; j < fftSize; ++j)
+                fftData[(size_t) j] = state.history[(size_t) ((state.historyIndex + j) % fftSize)];
+
+            window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+            fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+            // a full scale sine reads 0 dB: the Hann window's coherent gain is one half
+            const auto normalise = 4.0f / (float) fftSize;
+
+            // an exponential average of the power, a time constant of about 100 ms at 44.1 kHz
+            const auto smoothing = 0.9f;
+
+            for (size_t bin = 0; bin < state.power.size(); ++bin)
+            {
+                auto magnitude = fftData[bin] * normalise;
+                state.power[bin] = smoothing * state.power[bin] + (1.0f - smoothing) * magnitude * magnitude;
+            }
+
+            analysed = true;
+        }
+    };
+
+    consume (start1, size1);
+    consume (start2, size2);
+    state.fifo.finishedRead (size1 + size2);
+
+    return analysed;
+}
+
+juce::Path SpectrumAnalyser::makePath (const std::vector<float>& power, float width, float height) const
+{
+    juce::Path path;
+    auto binsPerHertz = (float) fftSize / (float) sampleRate.load();
+    auto lastBin = (float) (power.size() - 1);
+
+    // a point every other pixel, reading between bins linearly
+    for (float x = 0; x <= width; x += 2.0f)
+    {
+        auto frequency = minimumFrequency * std::pow (maximumFrequency / minimumFrequency, x / width);
+        auto position = juce::jmin (frequency * binsPerHertz, lastBin);
+        auto bin = (size_t) position;
+        auto next = juce::jmin (bin + 1, power.size() - 1);
+        auto value = power[bin] + (position - (float) bin) * (power[next] - power[bin]);
+
+        auto decibels = juce::jlimit (minimumDecibels, maximumDecibels, 10.0f * std::log10 (juce::jmax (value, 1.0e-12f)));
+        auto y = juce::jmap (decibels, minimumDecibels, maximumDecibels, height, 0.0f);
+
+        if (x == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+
+    return path;
+}
+
+//==============================================================================
+template void SpectrumAnalyser::push<float> (Source, const juce::dsp::AudioBlock<float>&) noexcept;
+template void SpectrumAnalyser::push<double> (Source, const juce::dsp::AudioBlock<double>&) noexcept;
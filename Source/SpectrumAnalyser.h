@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+
+    The pre / post spectrum behind the editor's display. The audio thread
+    only mixes each block down to mono and pushes it into a lock-free FIFO,
+    and only while the analyser is running. A background thread drains the
+    FIFOs, runs a windowed FFT every hop, averages the power spectra and
+    turns them into paths sized for the display. The message thread just
+    picks up the newest paths and strokes them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+class SpectrumAnalyser  : private juce::Thread
+{
+public:
+    enum Source
+    {
+        pre = 0,
+        post,
+        numSources
+    };
+
+    /** The paths for the current display size, in its local coordinates. */
+    struct Paths
+    {
+        juce::Path spectra[numSources];
+    };
+
+    // the display's frequency and level ranges
+    static constexpr float minimumFrequency = 20.0f, maximumFrequency = 20000.0f;
+    static constexpr float minimumDecibels = -90.0f, maximumDecibels = 0.0f;
+
+    /** Where a frequency sits across the display, 0 to 1 on a log scale. */
+    static float frequencyToProportion (float frequency) noexcept
+    {
+        return std::log (frequency / minimumFrequency) / std::log (maximumFrequency / minimumFrequency);
+    }
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    /** Any thread, before or while running. */
+    void setSampleRate (double newSampleRate) noexcept     { sampleRate = newSampleRate; }
+
+    /** Starts and stops the background thread. Pushing does nothing while it's stopped. */
+    void start();
+    void stop();
+
+    bool isRunning() const noexcept     { return running.load(); }
+
+    /** Audio thread. Mixes the block to mono into the source's FIFO, dropping whatever doesn't fit. */
+    template <typename SampleType>
+    void push (Source source, const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    //==============================================================================
+    /** Message thread. The size the paths are built for. */
+    void setDisplaySize (int width, int height) noexcept;
+
+    /** Message thread. Copies the newest paths into dest if there are new ones since the last call. */
+    bool readPaths (Paths& dest) noexcept     { return paths.read (dest); }
+
+private:
+    void run() override;
+
+    // returns true if at least one new frame was analysed
+    bool analyse (Source source);
+    juce::Path makePath (const std::vector<float>& power, float width, float height) const;
+
+    static constexpr int fftOrder = 11, fftSize = 1 << fftOrder, hopSize = fftSize / 4;
+    static constexpr int fifoSize = 1 << 15;
+
+    struct SourceState
+    {
+        juce::AbstractFifo fifo { fifoSize };
+        std::vector<float> fifoData = std::vector<float> (fifoSize);
+
+        // the last fftSize samples, oldest first from historyIndex
+        std::vector<float> history = std::vector<float> (fftSize);
+        int historyIndex = 0, samplesSinceFrame = 0;
+
+        // averaged power per bin
+        std::vector<float> power = std::vector<float> (fftSize / 2 + 1);
+    };
+
+    SourceState sources[numSources];
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> fftData = std::vector<float> (2 * fftSize);
+
+    std::atomic<bool> running { false };
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<int> displayWidth { 0 }, displayHeight { 0 };
+
+    TripleBuffer<Paths> paths;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyser)
+};
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+
+//==============================================================================
+SpectrumDisplay::SpectrumDisplay (SpectrumAnalyser& analyserToUse, std::atomic<float>& cutoffToShow, std::atomic<float>& lowcutToShow)
+    : analyser (analyserToUse), cutoff (cutoffToShow), lowcut (lowcutToShow)
+{
+    setOpaque (true);
+
+    analyser.start();
+    startTimerHz (30);
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+    stopTimer();
+    analyser.stop();
+}
+
+void SpectrumDisplay::resized()
+{
+    analyser.setDisplaySize (getWidth(), getHeight());
+}
+
+void SpectrumDisplay::timerCallback()
+{
+    auto newSpectrum = analyser.readPaths (paths);
+    auto filtersMoved = cutoff.load() != shownCutoff || lowcut.load() != shownLowcut;
+
+    if (newSpectrum || filtersMoved)
+        repaint();
+}
+
+float SpectrumDisplay::frequencyToX (float frequency) const noexcept
+{
+    auto proportion = SpectrumAnalyser::frequencyToProportion (juce::jlimit (SpectrumAnalyser::minimumFrequency,
+                                                                             SpectrumAnalyser::maximumFrequency, frequency));
+    return proportion * (float) getWidth();
+}
+
+//==============================================================================
+void SpectrumDisplay::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    g.fillAll (juce::Colour (0xff101010));
+
+    // a line at every decade
+    g.setColour (juce::Colour (0xff303030));
+
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+        g.drawVerticalLine (juce::roundToInt (frequencyToX (frequency)), 0.0f, bounds.getHeight());
+
+    g.setColour (juce::Colours::grey);
+    g.strokePath (paths.spectra[SpectrumAnalyser::pre], juce::PathStrokeType (1.0f));
+
+    g.setColour (juce::Colours::red);
+    g.strokePath (paths.spectra[SpectrumAnalyser::post], juce::PathStrokeType (1.5f));
+
+    // shade what the filters take away, with a line at each corner frequency
+    shownCutoff = cutoff.load();
+    shownLowcut = lowcut.load();
+
+    auto lowcutX = frequencyToX (shownLowcut);
+    auto cutoffX = frequencyToX (shownCutoff);
+
+    g.setColour (juce::Colours::black.withAlpha (0.5f));
+    g.fillRect (bounds.withRight (lowcutX));
+    g.fillRect (bounds.withLeft (cutoffX));
+
+    g.setColour (juce::Colours::darkred);
+    g.drawVerticalLine (juce::roundToInt (lowcutX), 0.0f, bounds.getHeight());
+    g.drawVerticalLine (juce::roundToInt (cutoffX), 0.0f, bounds.getHeight());
+}
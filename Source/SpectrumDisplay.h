@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.h
+
+    Draws the analyser's pre and post spectra with the low cut and cutoff
+    settings over them. The paths arrive ready-made from the analyser's
+    thread, so a repaint is just two strokes, and it only happens when
+    there's a new spectrum or a filter setting has moved, at most 30 times
+    a second.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyser.h"
+
+class SpectrumDisplay  : public juce::Component,
+                         private juce::Timer
+{
+public:
+    SpectrumDisplay (SpectrumAnalyser& analyserToUse, std::atomic<float>& cutoffToShow, std::atomic<float>& lowcutToShow);
+    ~SpectrumDisplay() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+
+    float frequencyToX (float frequency) const noexcept;
+
+    SpectrumAnalyser& analyser;
+    std::atomic<float>& cutoff;
+    std::atomic<float>& lowcut;
+
+    SpectrumAnalyser::Paths paths;
+    float shownCutoff = 0, shownLowcut = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumDisplay)
+};
@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+    StateFormat.cpp
+
+  ==============================================================================
+*/
+
+#include "StateFormat.h"
+
+namespace StateFormat
+{
+    namespace
+    {
+        constexpr juce::uint32 magic = 0x536d6e56;   // "VnmS" when read as little endian bytes
+
+        /** A bounds checked cursor over the blob. */
+        struct Reader
+        {
+            const char* data;
+            size_t size, position = 0;
+
+            // returns the next numBytes in place, or nullptr if the blob is shorter than that
+            const char* take (size_t numBytes) noexcept
+            {
+                if (numBytes > size - position)
+                    return nullptr;
+
+                auto* start = data + position;
+                position += numBytes;
+                return start;
+            }
+
+            bool readByte (juce::uint8& value) noexcept
+            {
+                auto* bytes = take (1);
+
+                if (bytes == nullptr)
+                    return false;
+
+                value = (juce::uint8) *bytes;
+                return true;
+            }
+
+            bool readShort (juce::uint16& value) noexcept
+            {
+                auto* bytes = take (2);
+
+                if (bytes == nullptr)
+                    return false;
+
+                value = juce::ByteOrder::littleEndianShort (bytes);
+                return true;
+            }
+
+            bool readInt (juce::uint32& value) noexcept
+            {
+                auto* bytes = take (4);
+
+                if (bytes == nullptr)
+                    return false;
+
+                value = juce::ByteOrder::littleEndianInt (bytes);
+                return true;
+            }
+
+            bool readFloat (float& value) noexcept
+            {
+                juce::uint32 bits;
+
+                if (! readInt (bits))
+                    return false;
+
+                std::memcpy (&value, &bits, sizeof (value));
+                return true;
+            }
+        };
+
+        juce::RangedAudioParameter* findParameter (const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                                                   int expectedIndex, const char* id, size_t length) noexcept
+        {
+            auto matches = [id, length] (juce::AudioProcessorParameter* parameter) -> juce::RangedAudioParameter*
+            {
+                auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+
+                if (ranged != nullptr
+                     && ranged->paramID.getNumBytesAsUTF8() == length
+                     && std::memcmp (ranged->paramID.toRawUTF8(), id, length) == 0)
+                    return ranged;
+
+                return nullptr;
+            };
+
+            // blobs from this build list the parameters in order, so the search rarely runs
+            if (juce::isPositiveAndBelow (expectedIndex, parameters.size()))
+                if (auto* parameter = matches (parameters.getUnchecked (expectedIndex)))
+                    return parameter;
+
+            for (auto* parameter : parameters)
+                if (auto* ranged = matches (parameter))
+                    return ranged;
+
+            return nullptr;
+        }
+
+        /** Walks the whole blob, applying it only if apply is true. */
+        bool parse (const void* data, int sizeInBytes, const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                    juce::ValueTree& state, bool apply)
+        {
+            if (sizeInBytes <= 0)
+                return false;
+
+            Reader reader { static_cast<const char*> (data), (size_t) sizeInBytes };
+
+            juce::uint32 header;
+            juce::uint16 version, numParameters, numProperties;
+
+            if (! reader.readInt (header) || header != magic || ! reader.readShort (version) || version < 1)
+                return false;
+
+            if (! reader.readShort (numParameters))
+                return false;
+
+            for (int i = 0; i < (int) numParameters; ++i)
+            {
+                juce::uint8 idLength;
+                const char* id;
+                float value;
+
+                if (! reader.readByte (idLength) || (id = reader.take (idLength)) == nullptr || ! reader.readFloat (value))
+                    return false;
+
+                if (! apply)
+                    continue;
+
+                if (auto* parameter = findParameter (parameters, i, id, idLength))
+                {
+                    auto normalised = parameter->convertTo0to1 (value);
+
+                    if (parameter->getValue() != normalised)
+                        parameter->setValueNotifyingHost (normalised);
+                }
+            }
+
+            if (! reader.readShort (numProperties))
+                return false;
+
+            // the long properties are the same apart from a four byte value length
+            for (auto longValues : { false, true })
+            {
+                if (longValues && (version < 2 || ! reader.readShort (numProperties)))
+                    break;
+
+                for (int i = 0; i < (int) numProperties; ++i)
+                {
+                    juce::uint8 nameLength;
+                    juce::uint16 shortLength = 0;
+                    juce::uint32 valueLength = 0;
+                    const char* name;
+                    const char* value;
+
+                    if (! reader.readByte (nameLength) || (name = reader.take (nameLength)) == nullptr
+                         || ! (longValues ? reader.readInt (valueLength) : reader.readShort (shortLength)))
+                        return false;
+
+                    if (! longValues)
+                        valueLength = shortLength;
+
+                    if ((value = reader.take (valueLength)) == nullptr)
+                        return false;
+
+                    if (apply && nameLength > 0)
+                        state.setProperty (juce::String::fromUTF8 (name, nameLength), juce::String::fromUTF8 (value, (int) valueLength), nullptr);
+                }
+            }
+
+            return true;
+        }
+
+        // ids and names have a one byte length, property values a two or four byte one
+        void writeText (juce::MemoryOutputStream& stream, const juce::String& text, int lengthBytes)
+        {
+            auto length = text.getNumBytesAsUTF8();
+
+            if (lengthBytes == 1)
+            {
+                // ids and names are the processor's own and never this long
+                jassert (length <= 0xff);
+                length = juce::jmin (length, (size_t) 0xff);
+                stream.writeByte ((char) length);
+            }
+            else if (lengthBytes == 2)
+            {
+                jassert (length <= 0xffff);
+                stream.writeShort ((short) length);
+            }
+            else
+            {
+                stream.writeInt ((int) length);
+            }
+
+            stream.write (text.toRawUTF8(), length);
+        }
+
+        // the properties with values short enough for a two byte length, or the rest
+        void writeProperties (juce::MemoryOutputStream& stream, const juce::ValueTree& state, bool longValues)
+        {
+            auto isLong = [&state] (int i) { return state[state.getPropertyName (i)].toString().getNumBytesAsUTF8() > 0xffff; };
+            auto numProperties = 0;
+
+            for (int i = 0; i < state.getNumProperties(); ++i)
+                if (isLong (i) == longValues)
+                    ++numProperties;
+
+            stream.writeShort ((short) numProperties);
+
+            for (int i = 0; i < state.getNumProperties(); ++i)
+            {
+                if (isLong (i) != longValues)
+                    continue;
+
+                auto name = state.getPropertyName (i);
+                writeText (stream, name.toString(), 1);
+                writeText (stream, state[name].toString(), longValues ? 4 : 2);
+            }
+        }
+    }
+
+    //==============================================================================
+    bool isBinaryState (const void* data, int sizeInBytes) noexcept
+    {
+        return sizeInBytes >= 4 && juce::ByteOrder::littleEndianInt (data) == magic;
+    }
+
+    void write (const juce::Array<juce::AudioProcessorParameter*>& parameters, const juce::ValueTree& state, juce::MemoryBlock& destData)
+    {
+        std::vector<ParameterValue> values;
+        values.reserve ((size_t) parameters.size());
+
+        for (auto* parameter : parameters)
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                values.push_back ({ ranged->paramID, ranged->convertFrom0to1 (ranged->getValue()) });
+
+        write (values, state, destData);
+    }
+
+    void write (const std::vector<ParameterValue>& values, const juce::ValueTree& state, juce::MemoryBlock& destData)
+    {
+        juce::MemoryOutputStream stream (destData, false);
+        stream.preallocate (8 + values.size() * 24);
+
+        stream.writeInt ((int) magic);
+        stream.writeShort ((short) currentVersion);
+        stream.writeShort ((short) values.size());
+
+        for (auto& value : values)
+        {
+            writeText (stream, value.id, 1);
+            stream.writeFloat (value.value);
+        }
+
+        // the long values go after everything version 1 had, so an older build still reads the rest
+        writeProperties (stream, state, false);
+        writeProperties (stream, state, true);
+    }
+
+    bool read (const void* data, int sizeInBytes, const juce::Array<juce::AudioProcessorParameter*>& parameters, juce::ValueTree& state)
+    {
+        return parse (data, sizeInBytes, parameters, state, false)
+            && parse (data, sizeInBytes, parameters, state, true);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    StateFormat.h
+
+    The binary format getStateInformation writes. Every parameter is
+    stored as its id and its real world value, followed by the properties
+    of the state tree's root, all little endian:
+
+        uint32      magic, "VnmS"
+        uint16      version
+        uint16      number of parameters
+                        uint8   id length, then the id's UTF-8 bytes
+                        float32 value, in the parameter's own range
+        uint16      number of properties
+                        uint8   name length, then the name's UTF-8 bytes
+                        uint16  value length, then the value's UTF-8 bytes
+
+    Version 2 appends the properties whose values are too long for that:
+
+        uint16      number of long properties
+                        uint8   name length, then the name's UTF-8 bytes
+                        uint32  value length, then the value's UTF-8 bytes
+
+    Reading needs no DOM and allocates nothing for the parameters: ids are
+    compared in place against the processor's parameters, trying the one at
+    the same index first. Unknown ids are skipped, and parameters the blob
+    doesn't mention keep their values, just as with the old XML state.
+    Later versions may only append to this layout, so an older build reads
+    what it knows and ignores the rest.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace StateFormat
+{
+    constexpr int currentVersion = 2;
+
+    /** True if the data starts like this format rather than like one of the old XML blobs. */
+    bool isBinaryState (const void* data, int sizeInBytes) noexcept;
+
+    /** A parameter's id and its value in the parameter's own range. */
+    struct ParameterValue
+    {
+        juce::String id;
+        float value;
+    };
+
+    /** Replaces destData with the parameters' current values and the state tree root's properties. */
+    void write (const juce::Array<juce::AudioProcessorParameter*>& parameters, const juce::ValueTree& state, juce::MemoryBlock& destData);
+
+    /** The same, from a list of values rather than from the parameters themselves. */
+    void write (const std::vector<ParameterValue>& values, const juce::ValueTree& state, juce::MemoryBlock& destData);
+
+    /** Checks the whole blob first, then applies it to the parameters and to the state tree's root.
+        Returns false and changes nothing if the blob is malformed.
+    */
+    bool read (const void* data, int sizeInBytes, const juce::Array<juce::AudioProcessorParameter*>& parameters, juce::ValueTree& state);
+}
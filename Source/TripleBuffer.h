@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+    Hands the most recent value of something from one thread to another
+    without locks or allocation. One thread writes, one thread reads, and the
+    reader always gets the newest complete value, skipping any it missed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename Type>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    /** Publishes a new value. Only ever call this from the writing thread. */
+    void write (const Type& newValue) noexcept
+    {
+        buffers[backIndex] = newValue;
+        backIndex = middleIndex.exchange (backIndex | freshFlag) & indexMask;
+    }
+
+    /** Copies the newest value into dest if one has been written since the last
+        read, otherwise leaves dest alone. Only ever call this from the reading thread.
+    */
+    bool read (Type& dest) noexcept
+    {
+        if ((middleIndex.load() & freshFlag) == 0)
+            return false;
+
+        frontIndex = middleIndex.exchange (frontIndex) & indexMask;
+        dest = buffers[frontIndex];
+        return true;
+    }
+
+private:
+    static constexpr int indexMask = 3, freshFlag = 4;
+
+    Type buffers[3] {};
+    int backIndex = 0, frontIndex = 1;
+    std::atomic<int> middleIndex { 2 };
+
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};
@@ -0,0 +1,389 @@
+/*
+  ==============================================================================
+
+    Headless batch renderer.
+
+    Streams WAV / AIFF files through VenomDistortionAudioProcessor in fixed
+    size chunks, so no file is ever loaded into memory whole, and renders
+    several files at once on a thread pool.
+
+    VenomBatchRenderer [options] <input files...>
+
+      --out <dir>           where to write the results (default: next to each input)
+      --suffix <text>       appended to each output file name (default: _venom)
+      --param <id>=<value>  sets a parameter to a real value, e.g. --param drive=12
+      --state <file>        loads a state blob saved by getStateInformation first
+      --block <samples>     chunk size (default: 1024)
+      --threads <n>         files rendered in parallel (default: number of cores)
+      --format wav|aiff     output format (default: same as the input)
+      --bits <n>            output bit depth (default: same as the input)
+      --stats <dir>         writes each file's per-block stage timings there as CSV
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+struct RenderSettings
+{
+    juce::File outputDirectory, statsDirectory;
+    juce::String suffix { "_venom" }, format;
+    juce::StringPairArray parameters;
+    juce::MemoryBlock state;
+    int blockSize = 1024, bitsPerSample = 0;
+};
+
+static juce::CriticalSection consoleLock;
+
+static void log (const juce::String& message)
+{
+    const juce::ScopedLock sl (consoleLock);
+    std::cout << message << std::endl;
+}
+
+//==============================================================================
+/** Applies the state blob and the --param overrides, in that order. */
+static juce::String applySettings (VenomDistortionAudioProcessor& processor, const RenderSettings& settings)
+{
+    if (settings.state.getSize() > 0)
+        processor.setStateInformation (settings.state.getData(), (int) settings.state.getSize());
+
+    for (auto& id : settings.parameters.getAllKeys())
+    {
+        auto* parameter = processor.treeState.getParameter (id);
+
+        if (parameter == nullptr)
+            return "unknown parameter '" + id + "'";
+
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (settings.parameters[id].getFloatValue()));
+    }
+
+    return {};
+}
+
+//==============================================================================
+class RenderJob  : public juce::ThreadPoolJob
+{
+public:
+    RenderJob (const juce::File& input, const RenderSettings& s, std::atomic<int>& failureCount)
+        : juce::ThreadPoolJob ("Render " + input.getFileName()),
+          inputFile (input), settings (s), failures (failureCount)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto error = render();
+
+        if (error.isEmpty())
+        {
+            log ("rendered " + inputFile.getFullPathName());
+        }
+        else
+        {
+            log ("failed " + inputFile.getFullPathName() + ": " + error);
+            ++failures;
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::File getOutputFile (bool aiff) const
+    {
+        auto directory = settings.outputDirectory == juce::File() ? inputFile.getParentDirectory()
+                                                                   : settings.outputDirectory;
+
+        return directory.getChildFile (inputFile.getFileNameWithoutExtension() + settings.suffix)
+                        .withFileExtension (aiff ? ".aiff" : ".wav");
+    }
+
+    juce::String render()
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (inputFile));
+
+        if (reader == nullptr)
+            return "couldn't open as WAV or AIFF";
+
+        auto numChannels = (int) reader->numChannels;
+        auto sampleRate = reader->sampleRate;
+
+        VenomDistortionAudioProcessor processor;
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (juce::AudioChannelSet::canonicalChannelSet (numChannels));
+        layout.outputBuses.add (juce::AudioChannelSet::canonicalChannelSet (numChannels));
+
+        if (! processor.setBusesLayout (layout))
+            return juce::String (numChannels) + " channel files aren't supported";
+
+        auto error = applySettings (processor, settings);
+
+        if (error.isNotEmpty())
+            return error;
+
+        // non-realtime lets the processor follow every parameter change exactly
+        processor.setNonRealtime (true);
+        processor.setRateAndBufferSizeDetails (sampleRate, settings.blockSize);
+        processor.prepareToPlay (sampleRate, settings.blockSize);
+
+        // the cabinet's response is built on a background thread. Rendering before it's in place would
+        // leave the cabinet off the first blocks, and the tail would be worked out without its decay
+        auto waitStart = juce::Time::getMillisecondCounter();
+
+        while (! processor.isCabinetReady())
+        {
+            if (juce::Time::getMillisecondCounter() - waitStart > 10000)
+                return "timed out loading the cabinet impulse response";
+
+            juce::Thread::sleep (5);
+        }
+
+        auto& stats = processor.getProcessingStats();
+        auto writeStats = settings.statsDirectory != juce::File();
+
+        if (writeStats)
+        {
+            auto statsFile = settings.statsDirectory.getChildFile (inputFile.getFileNameWithoutExtension() + settings.suffix + "_stats.csv");
+
+            if (! stats.startCsv (statsFile))
+                return "couldn't write " + statsFile.getFullPathName();
+        }
+
+        auto aiff = settings.format.isNotEmpty() ? settings.format.equalsIgnoreCase ("aiff")
+                                                 : inputFile.hasFileExtension ("aif;aiff");
+        auto outputFile = getOutputFile (aiff);
+        outputFile.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream> (outputFile);
+
+        if (stream->failedToOpen())
+            return "couldn't write " + outputFile.getFullPathName();
+
+        auto bitsPerSample = settings.bitsPerSample > 0 ? settings.bitsPerSample : (int) reader->bitsPerSample;
+
+        std::unique_ptr<juce::AudioFormat> format;
+
+        if (aiff)
+            format = std::make_unique<juce::AiffAudioFormat>();
+        else
+            format = std::make_unique<juce::WavAudioFormat>();
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                  bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+            return "can't write " + juce::String (bitsPerSample) + " bit " + format->getFormatName();
+
+        // the writer owns the stream now
+        stream.release();
+
+        // skip the oversampler's latency at the start and run the input's tail out at the end
+        auto latency = (juce::int64) processor.getLatencySamples();
+        auto tail = (juce::int64) std::ceil (processor.getTailLengthSeconds() * sampleRate);
+        auto totalToWrite = reader->lengthInSamples + tail;
+        auto toSkip = latency;
+
+        juce::AudioBuffer<float> buffer (numChannels, settings.blockSize);
+        juce::MidiBuffer midi;
+        juce::int64 readPosition = 0, written = 0;
+
+        while (written < totalToWrite)
+        {
+            buffer.clear();
+
+            auto numToRead = (int) juce::jmin ((juce::int64) settings.blockSize, reader->lengthInSamples - readPosition);
+
+            if (numToRead > 0)
+            {
+                reader->read (&buffer, 0, numToRead, readPosition, true, true);
+                readPosition += numToRead;
+            }
+
+            processor.processBlock (buffer, midi);
+
+            // there's no message loop running the processor's timer here, so drain the timings as we go
+            if (writeStats)
+                stats.update();
+
+            auto start = (int) juce::jmin ((juce::int64) settings.blockSize, toSkip);
+            toSkip -= start;
+
+            auto numToWrite = (int) juce::jmin ((juce::int64) (settings.blockSize - start), totalToWrite - written);
+
+            if (numToWrite > 0)
+            {
+                if (! writer->writeFromAudioSampleBuffer (buffer, start, numToWrite))
+                    return "write failed on " + outputFile.getFullPathName();
+
+                written += numToWrite;
+            }
+
+            if (shouldExit())
+                return "cancelled";
+        }
+
+        processor.releaseResources();
+
+        if (writeStats)
+        {
+            auto summary = stats.getSummary();
+            stats.stopCsv();
+
+            log (inputFile.getFileName() + ": average load " + juce::String (summary.averageLoad * 100.0, 2)
+                   + "%, peak " + juce::String (summary.peakLoad * 100.0, 2) + "%");
+        }
+
+        return {};
+    }
+
+    juce::File inputFile;
+    const RenderSettings& settings;
+    std::atomic<int>& failures;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "usage: VenomBatchRenderer [options] <input files...>" << std::endl
+              << "  --out <dir>           where to write the results (default: next to each input)" << std::endl
+              << "  --suffix <text>       appended to each output file name (default: _venom)" << std::endl
+              << "  --param <id>=<value>  sets a parameter to a real value, e.g. --param drive=12" << std::endl
+              << "  --state <file>        loads a state blob saved by getStateInformation first" << std::endl
+              << "  --block <samples>     chunk size (default: 1024)" << std::endl
+              << "  --threads <n>         files rendered in parallel (default: number of cores)" << std::endl
+              << "  --format wav|aiff     output format (default: same as the input)" << std::endl
+              << "  --bits <n>            output bit depth (default: same as the input)" << std::endl
+              << "  --stats <dir>         writes each file's per-block stage timings there as CSV" << std::endl;
+}
+
+int main (int argc, char* argv[])
+{
+    // the processor uses timers and async updates, so it needs the message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderSettings settings;
+    juce::Array<juce::File> inputs;
+    auto numThreads = juce::SystemStats::getNumCpus();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (juce::CharPointer_UTF8 (argv[i]));
+        auto hasValue = i + 1 < argc;
+        auto value = hasValue ? juce::String (juce::CharPointer_UTF8 (argv[i + 1])) : juce::String();
+
+        auto isOption = [&] (const char* name)
+        {
+            if (arg != name)
+                return false;
+
+            if (! hasValue)
+            {
+                std::cerr << arg << " needs a value" << std::endl;
+                std::exit (1);
+            }
+
+            ++i;
+            return true;
+        };
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+
+        if (isOption ("--out"))
+        {
+            settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+            settings.outputDirectory.createDirectory();
+        }
+        else if (isOption ("--stats"))
+        {
+            settings.statsDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+            settings.statsDirectory.createDirectory();
+        }
+        else if (isOption ("--suffix"))     settings.suffix = value;
+        else if (isOption ("--format"))     settings.format = value;
+        else if (isOption ("--bits"))       settings.bitsPerSample = value.getIntValue();
+        else if (isOption ("--block"))      settings.blockSize = juce::jmax (16, value.getIntValue());
+        else if (isOption ("--threads"))    numThreads = juce::jmax (1, value.getIntValue());
+        else if (isOption ("--param"))
+        {
+            if (! value.containsChar ('='))
+            {
+                std::cerr << "--param expects <id>=<value>, got " << value << std::endl;
+                return 1;
+            }
+
+            settings.parameters.set (value.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                     value.fromFirstOccurrenceOf ("=", false, false).trim());
+        }
+        else if (isOption ("--state"))
+        {
+            auto stateFile = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+
+            if (! stateFile.loadFileAsData (settings.state))
+            {
+                std::cerr << "couldn't read state file " << stateFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else if (arg.startsWith ("-"))
+        {
+            std::cerr << "unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            inputs.add (juce::File::getCurrentWorkingDirectory().getChildFile (arg));
+        }
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (settings.format.isNotEmpty() && ! settings.format.equalsIgnoreCase ("wav") && ! settings.format.equalsIgnoreCase ("aiff"))
+    {
+        std::cerr << "--format must be wav or aiff" << std::endl;
+        return 1;
+    }
+
+    // check the settings once up front rather than failing every file the same way
+    {
+        VenomDistortionAudioProcessor processor;
+        auto error = applySettings (processor, settings);
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    std::atomic<int> failures { 0 };
+
+    {
+        juce::ThreadPool pool (juce::jmin (numThreads, inputs.size()));
+
+        for (auto& input : inputs)
+            pool.addJob (new RenderJob (input, settings, failures), true);
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep (20);
+    }
+
+    log (juce::String (inputs.size() - failures) + " of " + juce::String (inputs.size()) + " files rendered");
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+    DSP chain benchmark.
+
+    Drives VenomDistortionAudioProcessor::processBlock directly over a sweep of
+    block sizes, channel counts, shapers, sample rates, single band or 4 band
+    and static or automated cutoff, and writes ns/sample and realtime factor for every case as JSON so
+    runs from different commits can be compared. It also times restoring the plugin's state from the
+    old XML format and from the binary one, which is what dominates loading a large session.
+
+    VenomBenchmark [options]
+
+      --out <file>      write the JSON here instead of to stdout
+      --label <text>    stored in the JSON, e.g. a commit hash
+      --seconds <s>     audio rendered per measurement (default: 1)
+      --repeats <n>     measurements per case, the fastest is kept (default: 3)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+struct BenchmarkSettings
+{
+    juce::File outputFile;
+    juce::String label;
+    double seconds = 1.0;
+    int repeats = 3;
+};
+
+struct BenchmarkCase
+{
+    double sampleRate;
+    int blockSize, numChannels;
+    int shaper, numBands;
+    bool automatedCutoff;
+};
+
+//==============================================================================
+/** Runs the sweep on its own thread, which stands in for the host's audio thread, while the
+    main thread runs the message loop so the processor's timer keeps recomputing filter
+    coefficients the way it does inside a host.
+*/
+class BenchmarkThread  : public juce::Thread
+{
+public:
+    explicit BenchmarkThread (const BenchmarkSettings& s)
+        : juce::Thread ("Benchmark"), settings (s)
+    {
+    }
+
+    juce::var getResults() const     { return results; }
+
+    void run() override
+    {
+        auto stateRestore = runStateRestore();
+        juce::Array<juce::var> cases;
+        runSweep (cases);
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("label", settings.label);
+        root->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+        root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        root->setProperty ("kernels", DistortionKernels::getKernels<float>().name);
+        root->setProperty ("seconds", settings.seconds);
+        root->setProperty ("repeats", settings.repeats);
+        root->setProperty ("stateRestore", stateRestore);
+        root->setProperty ("results", cases);
+        results = juce::var (root);
+
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    }
+
+private:
+    // returns as soon as the thread is asked to stop, with the cases measured so far
+    void runSweep (juce::Array<juce::var>& cases)
+    {
+        for (auto sampleRate : { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 })
+            for (int blockSize = 16; blockSize <= 8192; blockSize *= 2)
+                for (auto numChannels : { 1, 2 })
+                    for (int shaper = 0; shaper < ShaperAlgorithms::numTypes; ++shaper)
+                        for (auto numBands : { 1, 4 })
+                            for (auto automatedCutoff : { false, true })
+                            {
+                                if (threadShouldExit())
+                                    return;
+
+                                cases.add (runCase ({ sampleRate, blockSize, numChannels, shaper, numBands, automatedCutoff }));
+                            }
+    }
+
+    // hosts create and delete plugins on the message thread, and the processor's timer relies on that
+    static void* createProcessor (void*)               { return new VenomDistortionAudioProcessor(); }
+    static void* deleteProcessor (void* processor)     { delete static_cast<VenomDistortionAudioProcessor*> (processor); return nullptr; }
+
+    static void setParameter (VenomDistortionAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.treeState.getParameter (id);
+        jassert (parameter != nullptr);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    juce::var runStateRestore()
+    {
+        auto* messageManager = juce::MessageManager::getInstance();
+        auto* processor = static_cast<VenomDistortionAudioProcessor*> (messageManager->callFunctionOnMessageThread (createProcessor, nullptr));
+
+        setParameter (*processor, DRIVE_ID, 10.0f);
+        setParameter (*processor, CUTOFF_ID, 5000.0f);
+        setParameter (*processor, BANDS_ID, 3.0f);
+
+        juce::MemoryBlock binary, xml;
+        processor->getStateInformation (binary);
+
+        // the blob older versions wrote
+        if (auto state = processor->treeState.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary (*state, xml);
+
+        const int numRestores = 1000;
+
+        auto timeRestores = [&] (const juce::MemoryBlock& blob)
+        {
+            auto best = std::numeric_limits<double>::max();
+
+            for (int repeat = 0; repeat < settings.repeats; ++repeat)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numRestores; ++i)
+                    processor->setStateInformation (blob.getData(), (int) blob.getSize());
+
+                best = juce::jmin (best, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+            }
+
+            return best * 1.0e6 / numRestores;
+        };
+
+        auto xmlMicroseconds = timeRestores (xml);
+        auto binaryMicroseconds = timeRestores (binary);
+
+        messageManager->callFunctionOnMessageThread (deleteProcessor, processor);
+
+        std::cerr << "state restore: xml " << xmlMicroseconds << " us (" << xml.getSize() << " bytes), binary "
+                  << binaryMicroseconds << " us (" << binary.getSize() << " bytes)" << std::endl;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty ("xmlMicroseconds", xmlMicroseconds);
+        result->setProperty ("xmlBytes", (int) xml.getSize());
+        result->setProperty ("binaryMicroseconds", binaryMicroseconds);
+        result->setProperty ("binaryBytes", (int) binary.getSize());
+        return juce::var (result);
+    }
+
+    juce::var runCase (const BenchmarkCase& c)
+    {
+        auto* messageManager = juce::MessageManager::getInstance();
+        auto* processor = static_cast<VenomDistortionAudioProcessor*> (messageManager->callFunctionOnMessageThread (createProcessor, nullptr));
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (juce::AudioChannelSet::canonicalChannelSet (c.numChannels));
+        layout.outputBuses.add (juce::AudioChannelSet::canonicalChannelSet (c.numChannels));
+        processor->setBusesLayout (layout);
+
+        setParameter (*processor, TYPE_ID, (float) c.shaper);
+        setParameter (*processor, BANDS_ID, (float) (c.numBands - 1));
+
+        for (int band = 1; band <= c.numBands; ++band)
+            setParameter (*processor, BANDTYPE_ID + juce::String (band), (float) c.shaper);
+
+        setParameter (*processor, DRIVE_ID, 10.0f);
+        setParameter (*processor, CUTOFF_ID, 5000.0f);
+        setParameter (*processor, LOWCUT_ID, 80.0f);
+
+        processor->setRateAndBufferSizeDetails (c.sampleRate, c.blockSize);
+        processor->prepareToPlay (c.sampleRate, c.blockSize);
+
+        // a fixed block of noise copied in before each call, so every case shapes the same material
+        juce::AudioBuffer<float> source (c.numChannels, c.blockSize), buffer (c.numChannels, c.blockSize);
+        juce::Random random (1234);
+
+        for (int channel = 0; channel < c.numChannels; ++channel)
+            for (int sample = 0; sample < c.blockSize; ++sample)
+                source.setSample (channel, sample, random.nextFloat() - 0.5f);
+
+        juce::MidiBuffer midi;
+        auto numBlocks = juce::jmax (1, (int) (settings.seconds * c.sampleRate) / c.blockSize);
+
+        auto runBlocks = [&] (int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                // one sweep per second between 200 Hz and 20 kHz, moved once per block like host automation
+                if (c.automatedCutoff)
+                {
+                    auto phase = std::fmod ((double) i * c.blockSize / c.sampleRate, 1.0);
+                    auto position = phase < 0.5 ? phase * 2.0 : 2.0 - phase * 2.0;
+                    setParameter (*processor, CUTOFF_ID, (float) (200.0 * std::pow (100.0, position)));
+                }
+
+                for (int channel = 0; channel < c.numChannels; ++channel)
+                    buffer.copyFrom (channel, 0, source, channel, 0, c.blockSize);
+
+                processor->processBlock (buffer, midi);
+            }
+        };
+
+        // warm the caches and let the gain ramps settle before measuring
+        runBlocks (juce::jmax (1, numBlocks / 10));
+
+        auto best = std::numeric_limits<double>::max();
+
+        for (int repeat = 0; repeat < settings.repeats; ++repeat)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            runBlocks (numBlocks);
+            best = juce::jmin (best, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+
+        processor->releaseResources();
+        messageManager->callFunctionOnMessageThread (deleteProcessor, processor);
+
+        auto numSamples = (double) numBlocks * c.blockSize;
+        auto nsPerSample = best * 1.0e9 / (numSamples * c.numChannels);
+        auto realtimeFactor = (numSamples / c.sampleRate) / best;
+
+        std::cerr << c.sampleRate << " Hz, " << c.blockSize << " samples, " << c.numChannels << " ch, "
+                  << shaperNames[c.shaper] << ", " << c.numBands << " band, " << (c.automatedCutoff ? "automated" : "static")
+                  << ": " << nsPerSample << " ns/sample, " << realtimeFactor << "x realtime" << std::endl;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty ("sampleRate", c.sampleRate);
+        result->setProperty ("blockSize", c.blockSize);
+        result->setProperty ("channels", c.numChannels);
+        result->setProperty ("shaper", shaperNames[c.shaper]);
+        result->setProperty ("bands", c.numBands);
+        result->setProperty ("cutoff", c.automatedCutoff ? "automated" : "static");
+        result->setProperty ("nsPerSample", nsPerSample);
+        result->setProperty ("realtimeFactor", realtimeFactor);
+        return juce::var (result);
+    }
+
+    const BenchmarkSettings& settings;
+    const juce::StringArray shaperNames { ShaperAlgorithms::getNames() };
+    juce::var results;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BenchmarkThread)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "usage: VenomBenchmark [options]" << std::endl
+              << "  --out <file>      write the JSON here instead of to stdout" << std::endl
+              << "  --label <text>    stored in the JSON, e.g. a commit hash" << std::endl
+              << "  --seconds <s>     audio rendered per measurement (default: 1)" << std::endl
+              << "  --repeats <n>     measurements per case, the fastest is kept (default: 3)" << std::endl;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchmarkSettings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (juce::CharPointer_UTF8 (argv[i]));
+        auto value = i + 1 < argc ? juce::String (juce::CharPointer_UTF8 (argv[i + 1])) : juce::String();
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+
+        if (value.isEmpty())
+        {
+            std::cerr << "unknown or incomplete option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+
+        if (arg == "--out")             settings.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (value);
+        else if (arg == "--label")      settings.label = value;
+        else if (arg == "--seconds")    settings.seconds = juce::jmax (0.01, value.getDoubleValue());
+        else if (arg == "--repeats")    settings.repeats = juce::jmax (1, value.getIntValue());
+        else
+        {
+            std::cerr << "unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+
+        ++i;
+    }
+
+    BenchmarkThread benchmark (settings);
+    benchmark.startThread (juce::Thread::realtimeAudioPriority);
+
+    // returns once the benchmark thread calls stopDispatchLoop
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    benchmark.waitForThreadToExit (-1);
+
+    auto json = juce::JSON::toString (benchmark.getResults());
+
+    if (settings.outputFile == juce::File())
+    {
+        std::cout << json << std::endl;
+    }
+    else if (! settings.outputFile.replaceWithText (json))
+    {
+        std::cerr << "couldn't write " << settings.outputFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}